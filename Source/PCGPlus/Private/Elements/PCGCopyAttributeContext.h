@@ -0,0 +1,127 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Data/PCGPointData.h"
+#include "Helpers/PCGJoinCache.h"
+#include "Helpers/PCGJoinIndex.h"
+#include "Helpers/PCGMatchKeys.h"
+#include "Metadata/Accessors/IPCGAttributeAccessor.h"
+#include "Metadata/Accessors/PCGAttributeAccessorKeys.h"
+#include "PCGContext.h"
+#include "UObject/StrongObjectPtr.h"
+
+/** Stages of a copy, in order. Each one can be spread over several executions when time slicing. */
+enum class EPCGCopyAttributeStage : uint8
+{
+	Setup,
+	Match,
+	Copy,
+	Done
+};
+
+/** Type erased column of source values, read once so they can be gathered in match order. */
+struct FPCGCopyAttributeSourceColumn
+{
+	virtual ~FPCGCopyAttributeSourceColumn() = default;
+};
+
+/** One source to target copy. All of them write to the same output, through the same match. */
+struct FPCGCopyAttributeOperation
+{
+	/** Direct attribute to attribute copy between points, through value keys */
+	const FPCGMetadataAttributeBase* SourceAttribute = nullptr;
+	FPCGMetadataAttributeBase* TargetAttribute = nullptr;
+
+	/** When deduplicating, the target value key of each source value key, filled as source values are first used. Empty otherwise. */
+	TArray<PCGMetadataValueKey> ValueKeyRemap;
+
+	/** Generic copy through accessors, when either side is not a plain attribute */
+	TUniquePtr<const IPCGAttributeAccessor> InputAccessor;
+	TUniquePtr<const IPCGAttributeAccessorKeys> InputKeys;
+	TUniquePtr<IPCGAttributeAccessor> OutputAccessor;
+	TUniquePtr<IPCGAttributeAccessorKeys> OutputKeys;
+	TUniquePtr<FPCGCopyAttributeSourceColumn> SourceColumn;
+	bool bCanReadConcurrently = false;
+	bool bCanWriteConcurrently = false;
+
+	bool IsDirect() const { return SourceAttribute != nullptr; }
+};
+
+/** State of the copy into one target data. Targets are independent from each other and only share the source. */
+struct FPCGCopyAttributeTarget
+{
+	EPCGCopyAttributeStage Stage = EPCGCopyAttributeStage::Setup;
+
+	const UPCGSpatialData* TargetSpatialData = nullptr;
+
+	/** Output being written to, removed from the output data if the copy fails. */
+	UPCGSpatialData* OutputSpatialData = nullptr;
+
+	/** Join of the target points against the source points while it is being computed, when matching by attribute. */
+	TUniquePtr<UE::PCGPlus::IJoinTask> MatchTask;
+	UE::PCGPlus::FMatchKeys MatchKeys;
+	UE::PCGPlus::FJoinCacheKey MatchCacheKey;
+
+	/** Completed join, computed or reused from the join cache. */
+	TSharedPtr<const UE::PCGPlus::FJoinResult> MatchResult;
+	bool bMatchFromCache = false;
+
+	/** When sampling, the source sampled at each target point, which is what the values are read from. */
+	bool bSample = false;
+	TArray<FPCGPoint> SampledPoints;
+
+	TArray<FPCGCopyAttributeOperation> Operations;
+
+	/** Mappings that were moved in place when preparing, and have no operation. */
+	int32 NumMoved = 0;
+
+	/** Whether the output points were given their own entries, which direct copies do once before their first slice. */
+	bool bEntriesInitialized = false;
+
+	/** Operation being run, and index of the next element it will copy. */
+	int32 CurrentOperation = 0;
+	int32 CurrentIndex = 0;
+
+	bool bAborted = false;
+
+	/** Raised on the worker threads, and logged by the executing thread after each round. */
+	TArray<FText> Errors;
+	TArray<FText> VerboseMessages;
+
+	/** Totals over all executions, for the debug info. */
+	int64 BytesCopied = 0;
+	double ExecutionSeconds = 0.0;
+};
+
+/** A source and the targets copied from it, as indices of the inputs on their pins. */
+struct FPCGCopyAttributeBatch
+{
+	int32 SourceInputIndex = INDEX_NONE;
+	TArray<int32> TargetInputIndices;
+};
+
+struct FPCGCopyAttributeContext : public FPCGContext
+{
+	/** Batches are copied one after the other. Everything below them is the state of the current batch. */
+	bool bPaired = false;
+	TArray<FPCGCopyAttributeBatch> Batches;
+	int32 CurrentBatch = 0;
+
+	bool bPrepared = false;
+
+	const UPCGSpatialData* SourceSpatialData = nullptr;
+	const UPCGPointData* SourcePointData = nullptr;
+
+	/** Holds the metadata the source writes its samples to, shared by all the sampled targets. */
+	TStrongObjectPtr<UPCGPointData> SampleData;
+
+	/** Source side of the joins, read once for all targets. */
+	UE::PCGPlus::FMatchKeys SourceMatchKeys;
+	UE::PCGPlus::EJoinDuplicatePolicy DuplicatePolicy = UE::PCGPlus::EJoinDuplicatePolicy::First;
+
+	/** When aggregating, maps each source point to the first source point with the same match value, which holds the aggregate. */
+	TArray<int32> SourceGroups;
+
+	TArray<FPCGCopyAttributeTarget> Targets;
+};
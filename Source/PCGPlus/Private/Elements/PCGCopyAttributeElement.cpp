@@ -2,19 +2,53 @@
 
 #include "Elements/PCGCopyAttributeElement.h"
 
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
 #include "Data/PCGPointData.h"
 #include "Data/PCGSpatialData.h"
+#include "Elements/PCGCopyAttributeContext.h"
 #include "Elements/Metadata/PCGMetadataElementCommon.h"
+#include "HAL/PlatformTime.h"
+#include "Helpers/PCGAggregation.h"
+#include "Helpers/PCGConvert.h"
+#include "Helpers/PCGJoinIndex.h"
+#include "Helpers/PCGMatchKeys.h"
+#include "Helpers/PCGNearestNeighbour.h"
+#include "Helpers/PCGRangeJoin.h"
+#include "Helpers/PCGScratch.h"
 #include "Metadata/Accessors/IPCGAttributeAccessor.h"
 #include "Metadata/Accessors/PCGAttributeAccessorHelpers.h"
 #include "Metadata/Accessors/PCGAttributeAccessorKeys.h"
 #include "Metadata/Accessors/PCGCustomAccessor.h"
+#include "Misc/ScopeExit.h"
 #include "PCGContext.h"
 #include "PCGModule.h"
 #include "PCGPin.h"
+#include "PCGPlusCustomVersion.h"
+#include "PCGPlusStats.h"
+
+#include <atomic>
 
 #define LOCTEXT_NAMESPACE "PCGCopyAttributeElement"
 
+DECLARE_CYCLE_STAT(TEXT("Copy Attribute - Prepare"), STAT_PCGPlus_CopyAttribute_Prepare, STATGROUP_PCGPlus);
+DECLARE_CYCLE_STAT(TEXT("Copy Attribute - Duplicate"), STAT_PCGPlus_CopyAttribute_Duplicate, STATGROUP_PCGPlus);
+DECLARE_CYCLE_STAT(TEXT("Copy Attribute - Read Keys"), STAT_PCGPlus_CopyAttribute_ReadKeys, STATGROUP_PCGPlus);
+DECLARE_CYCLE_STAT(TEXT("Copy Attribute - Match"), STAT_PCGPlus_CopyAttribute_Match, STATGROUP_PCGPlus);
+DECLARE_CYCLE_STAT(TEXT("Copy Attribute - Verify"), STAT_PCGPlus_CopyAttribute_Verify, STATGROUP_PCGPlus);
+DECLARE_CYCLE_STAT(TEXT("Copy Attribute - Copy Value Keys"), STAT_PCGPlus_CopyAttribute_CopyValueKeys, STATGROUP_PCGPlus);
+DECLARE_CYCLE_STAT(TEXT("Copy Attribute - Copy Values"), STAT_PCGPlus_CopyAttribute_CopyValues, STATGROUP_PCGPlus);
+DECLARE_CYCLE_STAT(TEXT("Copy Attribute - Remove Unmatched"), STAT_PCGPlus_CopyAttribute_RemoveUnmatched, STATGROUP_PCGPlus);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Points Copied"), STAT_PCGPlus_PointsCopied, STATGROUP_PCGPlus);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Points Matched"), STAT_PCGPlus_PointsMatched, STATGROUP_PCGPlus);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Points Unmatched"), STAT_PCGPlus_PointsUnmatched, STATGROUP_PCGPlus);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Direct Attribute Copies"), STAT_PCGPlus_DirectCopies, STATGROUP_PCGPlus);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Accessor Copies"), STAT_PCGPlus_AccessorCopies, STATGROUP_PCGPlus);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Moved Attributes"), STAT_PCGPlus_MovedAttributes, STATGROUP_PCGPlus);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Joined Targets"), STAT_PCGPlus_JoinedTargets, STATGROUP_PCGPlus);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cached Matches"), STAT_PCGPlus_CachedMatches, STATGROUP_PCGPlus);
+DECLARE_MEMORY_STAT(TEXT("Bytes Copied"), STAT_PCGPlus_BytesCopied, STATGROUP_PCGPlus);
+
 namespace UE::PCGPlus::Private
 {
 	static FName NodeName = TEXT("CopyAttribute");
@@ -25,48 +59,644 @@ namespace UE::PCGPlus::Private
 	static FName SourceMatchLabel = TEXT("Source");
 	static FName TargetMatchLabel = TEXT("Target");
 
-	// template <typename T, typename... Ts> constexpr bool is_same_v = (std::is_same_v<T, Ts> && ...)
-	template <typename DataType>
-	struct TPCGDataTypeConstraint
+	/** Number of elements processed between two checks of the time budget. */
+	static constexpr int32 ElementsPerTimeSlice = 64 * 1024;
+
+	UE::PCGPlus::EJoinDuplicatePolicy GetJoinDuplicatePolicy(EPCGCopyAttributeDuplicatePolicy InPolicy)
+	{
+		return InPolicy == EPCGCopyAttributeDuplicatePolicy::Last ? UE::PCGPlus::EJoinDuplicatePolicy::Last : UE::PCGPlus::EJoinDuplicatePolicy::First;
+	}
+
+	bool IsAggregating(const FPCGCopyAttributeContext* Context, const UPCGCopyAttributeSettings* Settings)
+	{
+		return Context->SourcePointData && Settings->MatchMode == EPCGCopyAttributeMatchMode::Attribute && Settings->Aggregation != EPCGCopyAttributeAggregation::None;
+	}
+
+	UE::PCGPlus::EAggregation GetAggregation(EPCGCopyAttributeAggregation InAggregation)
+	{
+		switch (InAggregation)
+		{
+		case EPCGCopyAttributeAggregation::Min:
+			return UE::PCGPlus::EAggregation::Min;
+		case EPCGCopyAttributeAggregation::Max:
+			return UE::PCGPlus::EAggregation::Max;
+		case EPCGCopyAttributeAggregation::Mean:
+			return UE::PCGPlus::EAggregation::Mean;
+		case EPCGCopyAttributeAggregation::Count:
+			return UE::PCGPlus::EAggregation::Count;
+		default:
+			return UE::PCGPlus::EAggregation::Sum;
+		}
+	}
+
+	/** Drops the output of the target and skips its remaining stages. */
+	void AbortTarget(FPCGCopyAttributeTarget& Target)
+	{
+		Target.bAborted = true;
+		Target.Stage = EPCGCopyAttributeStage::Done;
+	}
+
+	/** Aborts the target from the worker running it. */
+	void FailTarget(FPCGCopyAttributeTarget& Target, FText InError)
+	{
+		Target.Errors.Add(MoveTemp(InError));
+		AbortTarget(Target);
+	}
+
+	/** Logs what the targets raised during a round, from the executing thread. */
+	void LogTargetMessages(FPCGCopyAttributeContext* Context)
+	{
+		for (FPCGCopyAttributeTarget& Target : Context->Targets)
+		{
+			for (const FText& Message : Target.VerboseMessages)
+			{
+				PCGE_LOG_C(Verbose, LogOnly, Context, Message);
+			}
+
+			for (const FText& Error : Target.Errors)
+			{
+				PCGE_LOG_C(Error, GraphAndLog, Context, Error);
+			}
+
+			Target.VerboseMessages.Reset();
+			Target.Errors.Reset();
+		}
+	}
+
+	/**
+	 * Splits the inputs into batches of a source and its targets. A single source is copied to every target.
+	 * With several, each target is copied from the source sharing the most tags with it, like the outputs of two partitions on the same values.
+	 */
+	void PairInputs(FPCGCopyAttributeContext* Context)
 	{
-		static_assert(std::is_base_of_v<UPCGData, DataType>, "DataType must be derived from UPCGData.");
+		const TArray<FPCGTaggedData> SourceInputs = Context->InputData.GetInputsByPin(SourceLabel);
+		const TArray<FPCGTaggedData> TargetInputs = Context->InputData.GetInputsByPin(TargetLabel);
+
+		if (SourceInputs.IsEmpty() || TargetInputs.IsEmpty())
+		{
+			PCGE_LOG_C(Warning, LogOnly, Context, FText::Format(LOCTEXT("WrongNumberOfInputs", "Source input contains {0} data elements and Target inputs contain {1} data elements, but both should contain at least 1"), SourceInputs.Num(), TargetInputs.Num()));
+			return;
+		}
 
-		static bool All(std::initializer_list<const UPCGData*> InDataItems)
+		TMap<FString, TArray<int32>> SourcesByTag;
+		Context->Batches.SetNum(SourceInputs.Num());
+		for (int32 SourceIdx = 0; SourceIdx < SourceInputs.Num(); ++SourceIdx)
 		{
-			for (const UPCGData* DataItem : InDataItems)
+			Context->Batches[SourceIdx].SourceInputIndex = SourceIdx;
+
+			for (const FString& Tag : SourceInputs[SourceIdx].Tags)
 			{
-				if (!DataItem || !DataItem->IsA(DataType::StaticClass()))
+				SourcesByTag.FindOrAdd(Tag).Add(SourceIdx);
+			}
+		}
+
+		TMap<int32, int32> NumSharedTags;
+		for (int32 TargetIdx = 0; TargetIdx < TargetInputs.Num(); ++TargetIdx)
+		{
+			int32 BestSourceIdx = SourceInputs.Num() == 1 ? 0 : INDEX_NONE;
+			int32 BestNumShared = 0;
+			bool bTied = false;
+
+			if (SourceInputs.Num() > 1)
+			{
+				NumSharedTags.Reset();
+				for (const FString& Tag : TargetInputs[TargetIdx].Tags)
 				{
-					return false;
+					if (const TArray<int32>* Sources = SourcesByTag.Find(Tag))
+					{
+						for (const int32 SourceIdx : *Sources)
+						{
+							++NumSharedTags.FindOrAdd(SourceIdx);
+						}
+					}
+				}
+
+				for (const TPair<int32, int32>& Shared : NumSharedTags)
+				{
+					if (Shared.Value > BestNumShared)
+					{
+						BestSourceIdx = Shared.Key;
+						BestNumShared = Shared.Value;
+						bTied = false;
+					}
+					else if (Shared.Value == BestNumShared)
+					{
+						bTied = true;
+					}
 				}
 			}
-			return true;
+
+			if (BestSourceIdx == INDEX_NONE || bTied)
+			{
+				PCGE_LOG_C(Error, GraphAndLog, Context, FText::Format(LOCTEXT("NoSourceForTarget", "Target {0} does not share more tags with one source than with any other, so it has no source to copy from"), TargetIdx));
+				continue;
+			}
+
+			Context->Batches[BestSourceIdx].TargetInputIndices.Add(TargetIdx);
 		}
 
-		static bool Any(std::initializer_list<const UPCGData*> InDataItems)
+		Context->Batches.RemoveAll([](const FPCGCopyAttributeBatch& Batch) { return Batch.TargetInputIndices.IsEmpty(); });
+	}
+
+	/** Drops the state of the current batch, once all its targets are done, and moves to the next one. */
+	void NextBatch(FPCGCopyAttributeContext* Context)
+	{
+		Context->bPrepared = false;
+		Context->SourceSpatialData = nullptr;
+		Context->SourcePointData = nullptr;
+		Context->SampleData.Reset();
+		Context->SourceMatchKeys.Reset();
+		Context->SourceGroups.Reset();
+		Context->Targets.Reset();
+		++Context->CurrentBatch;
+	}
+
+	/** Reads the match keys of each target and prepares their joins against the source. Targets that cannot be matched are aborted. */
+	void CreateMatchTasks(FPCGCopyAttributeContext* Context, TArrayView<FPCGCopyAttributeTarget*> InTargets, TArrayView<const FPCGAttributePropertyInputSelector> InTargetSelectors)
+	{
+		const FMatchKeys& SourceKeys = Context->SourceMatchKeys;
+
+		TSharedPtr<const TJoinIndex<uint64>> SharedSourceIndex;
+		if (InTargets.Num() > 1)
+		{
+			TSharedPtr<TJoinIndex<uint64>> SourceIndex = MakeShared<TJoinIndex<uint64>>();
+			SourceIndex->Build(SourceKeys.Fingerprints);
+			SharedSourceIndex = MoveTemp(SourceIndex);
+		}
+
+		for (FPCGCopyAttributeTarget* Target : InTargets)
 		{
-			for (const UPCGData* DataItem : InDataItems)
+			bool bKeysRead = false;
+			{
+				SCOPE_CYCLE_COUNTER(STAT_PCGPlus_CopyAttribute_ReadKeys);
+				bKeysRead = Target->MatchKeys.Read(Context, Target->TargetSpatialData, InTargetSelectors, &SourceKeys);
+			}
+
+			if (!bKeysRead)
+			{
+				AbortTarget(*Target);
+				continue;
+			}
+
+			// Only the key values are kept on the target, to verify the join
+			TArray<uint64> TargetFingerprints = MoveTemp(Target->MatchKeys.Fingerprints);
+
+			if (SharedSourceIndex.IsValid())
 			{
-				if (!DataItem || DataItem->IsA(DataType::StaticClass()))
+				Target->MatchTask = MakeUnique<TJoinTask<uint64>>(SharedSourceIndex, MoveTemp(TargetFingerprints), Context->DuplicatePolicy);
+			}
+			else
+			{
+				Target->MatchTask = MakeUnique<TJoinTask<uint64>>(TScratchPool<uint64>::AcquireCopy(SourceKeys.Fingerprints), MoveTemp(TargetFingerprints), Context->DuplicatePolicy);
+			}
+
+			Target->Stage = EPCGCopyAttributeStage::Match;
+		}
+	}
+
+	/** Prepares the nearest point matches of the targets, over one tree shared by all of them. */
+	void CreateNearestMatchTasks(FPCGCopyAttributeContext* Context, TArrayView<FPCGCopyAttributeTarget*> InTargets, double InMaxDistance)
+	{
+		const TArray<FPCGPoint>& SourcePoints = Context->SourcePointData->GetPoints();
+
+		TArray<FVector> SourcePositions;
+		SourcePositions.SetNumUninitialized(SourcePoints.Num());
+		for (int32 PointIdx = 0; PointIdx < SourcePoints.Num(); ++PointIdx)
+		{
+			SourcePositions[PointIdx] = SourcePoints[PointIdx].Transform.GetLocation();
+		}
+
+		TSharedPtr<FKdTree> SourceTree = MakeShared<FKdTree>();
+		SourceTree->Build(SourcePositions);
+
+		for (FPCGCopyAttributeTarget* Target : InTargets)
+		{
+			const TArray<FPCGPoint>& TargetPoints = CastChecked<const UPCGPointData>(Target->TargetSpatialData)->GetPoints();
+
+			TArray<FVector> TargetPositions;
+			TargetPositions.SetNumUninitialized(TargetPoints.Num());
+			for (int32 PointIdx = 0; PointIdx < TargetPoints.Num(); ++PointIdx)
+			{
+				TargetPositions[PointIdx] = TargetPoints[PointIdx].Transform.GetLocation();
+			}
+
+			Target->MatchTask = MakeNearestJoinTask(SourceTree, MoveTemp(TargetPositions), InMaxDistance);
+			Target->Stage = EPCGCopyAttributeStage::Match;
+		}
+	}
+
+	/** Reads the values of an attribute/property as doubles, for range matches. */
+	bool ReadRangeValues(FPCGCopyAttributeContext* Context, const UPCGData* InData, const FPCGAttributePropertyInputSelector& InSelector, TArray<double>& OutValues)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_PCGPlus_CopyAttribute_ReadKeys);
+
+		const FPCGAttributePropertyInputSelector Selector = InSelector.CopyAndFixLast(InData);
+
+		TUniquePtr<const IPCGAttributeAccessor> Accessor = PCGAttributeAccessorHelpers::CreateConstAccessor(InData, Selector);
+		TUniquePtr<const IPCGAttributeAccessorKeys> Keys = PCGAttributeAccessorHelpers::CreateConstKeys(InData, Selector);
+		if (!Accessor.IsValid() || !Keys.IsValid())
+		{
+			PCGE_LOG(Error, GraphAndLog, FText::Format(LOCTEXT("FailedToCreateRangeAccessor", "Failed to create range accessor or iterator for '{0}'"), Selector.GetDisplayText()));
+			return false;
+		}
+
+		OutValues.SetNumUninitialized(Keys->GetNum());
+
+		const bool bRead = CanReadConvertedRange(Accessor->GetUnderlyingType(), PCG::Private::MetadataTypes<double>::Id)
+			? ReadConvertedRange<double>(*Accessor, *Keys, 0, OutValues)
+			: Accessor->GetRange<double>(OutValues, 0, *Keys, EPCGAttributeAccessorFlags::AllowBroadcast | EPCGAttributeAccessorFlags::AllowConstructible);
+
+		if (!bRead)
+		{
+			PCGE_LOG(Error, GraphAndLog, FText::Format(LOCTEXT("RangeReadFailed", "Failed to read range attribute/property '{0}', or it cannot be converted to a double"), Selector.GetDisplayText()));
+			return false;
+		}
+
+		return true;
+	}
+
+	/** Prepares the range matches of the targets, on the main match keys only, over one index shared by all of them. */
+	void CreateRangeMatchTasks(FPCGCopyAttributeContext* Context, const UPCGCopyAttributeSettings* Settings, TArrayView<FPCGCopyAttributeTarget*> InTargets)
+	{
+		TArray<double> SourceMins;
+		TArray<double> SourceMaxs;
+
+		bool bSourceRead = ReadRangeValues(Context, Context->SourcePointData, Settings->SourceMatchAttributeProperty, SourceMins);
+		if (bSourceRead && Settings->RangeMode == EPCGCopyAttributeRangeMode::Interval)
+		{
+			bSourceRead = ReadRangeValues(Context, Context->SourcePointData, Settings->SourceRangeMaxAttributeProperty, SourceMaxs);
+			if (bSourceRead && SourceMaxs.Num() != SourceMins.Num())
+			{
+				PCGE_LOG(Error, GraphAndLog, LOCTEXT("MismatchingRangeCount", "Source range max does not have the same number of elements as the source match attribute/property"));
+				bSourceRead = false;
+			}
+		}
+		else if (bSourceRead)
+		{
+			const double Tolerance = FMath::Max(Settings->MatchTolerance, 0.0);
+
+			SourceMaxs.SetNumUninitialized(SourceMins.Num());
+			for (int32 Idx = 0; Idx < SourceMins.Num(); ++Idx)
+			{
+				SourceMaxs[Idx] = SourceMins[Idx] + Tolerance;
+				SourceMins[Idx] -= Tolerance;
+			}
+		}
+
+		if (!bSourceRead)
+		{
+			for (FPCGCopyAttributeTarget* Target : InTargets)
+			{
+				AbortTarget(*Target);
+			}
+
+			return;
+		}
+
+		TSharedPtr<FRangeIndex> SourceIndex = MakeShared<FRangeIndex>();
+		SourceIndex->Build(SourceMins, SourceMaxs);
+
+		for (FPCGCopyAttributeTarget* Target : InTargets)
+		{
+			TArray<double> TargetValues;
+			if (!ReadRangeValues(Context, Target->TargetSpatialData, Settings->TargetMatchAttributeProperty, TargetValues))
+			{
+				AbortTarget(*Target);
+				continue;
+			}
+
+			Target->MatchTask = MakeRangeJoinTask(SourceIndex, MoveTemp(TargetValues), Context->DuplicatePolicy);
+			Target->Stage = EPCGCopyAttributeStage::Match;
+		}
+	}
+
+	/** Samples the source at the transform and bounds of each target point, as the match of a sampled target. */
+	class FSampleTask final : public IJoinTask
+	{
+	public:
+		FSampleTask(const UPCGSpatialData* InSource, const UPCGPointData* InTarget, UPCGMetadata* InSampleMetadata, TArrayView<FPCGPoint> InOutSamples, int32 InBatchSize)
+			: Source(InSource)
+			, TargetPoints(InTarget->GetPoints())
+			, SampleMetadata(InSampleMetadata)
+			, Samples(InOutSamples)
+			, BatchSize(FMath::Max(InBatchSize, 1))
+		{
+			check(Samples.Num() == TargetPoints.Num());
+			Result.TargetToSource.SetNumUninitialized(TargetPoints.Num());
+		}
+
+		virtual bool Step(int32 InNumElements) override
+		{
+			TRACE_CPUPROFILER_EVENT_SCOPE(FSampleTask::Step);
+
+			const int32 EndIndex = FMath::Min(NextIndex + InNumElements, TargetPoints.Num());
+			const int32 NumBatches = FMath::DivideAndRoundUp(EndIndex - NextIndex, BatchSize);
+
+			// Samplers only add entries to the sample metadata under its lock, so batches can sample concurrently
+			ParallelFor(NumBatches, [this, EndIndex](int32 BatchIdx)
+			{
+				const int32 Start = NextIndex + BatchIdx * BatchSize;
+				const int32 End = FMath::Min(Start + BatchSize, EndIndex);
+				for (int32 PointIdx = Start; PointIdx < End; ++PointIdx)
 				{
-					return true;
+					const FPCGPoint& TargetPoint = TargetPoints[PointIdx];
+					FPCGPoint& Sample = Samples[PointIdx];
+					Sample = FPCGPoint();
+
+					const bool bSampled = Source->SamplePoint(TargetPoint.Transform, TargetPoint.GetLocalBounds(), Sample, SampleMetadata);
+					Result.TargetToSource[PointIdx] = bSampled ? PointIdx : INDEX_NONE;
 				}
+			});
+
+			NextIndex = EndIndex;
+			if (NextIndex < TargetPoints.Num())
+			{
+				return false;
 			}
-			return false;
+
+			Result.UpdateCounts();
+			return true;
 		}
 
-		static bool None(std::initializer_list<const UPCGData*> InDataItems)
+		virtual const FJoinResult& GetResult() const override { return Result; }
+		virtual FJoinResult TakeResult() override { return MoveTemp(Result); }
+
+	private:
+		const UPCGSpatialData* Source = nullptr;
+		TArrayView<const FPCGPoint> TargetPoints;
+		UPCGMetadata* SampleMetadata = nullptr;
+		TArrayView<FPCGPoint> Samples;
+		int32 BatchSize = 1;
+		int32 NextIndex = 0;
+		FJoinResult Result;
+	};
+
+	/** Marks source value keys not added to the target yet, in the value key remap of an operation. */
+	static constexpr PCGMetadataValueKey UnmappedValueKey = PCGDefaultValueKey - 1;
+
+	/** Turns source value keys into target value keys, adding each source value to the target the first time it is used. */
+	void RemapValueKeys(FPCGCopyAttributeOperation& Operation, TArrayView<PCGMetadataValueKey> InOutValueKeys)
+	{
+		auto Remap = [&Operation, InOutValueKeys](auto Dummy) -> bool
 		{
-			for (const UPCGData* DataItem : InDataItems)
+			using AttributeType = decltype(Dummy);
+
+			const FPCGMetadataAttribute<AttributeType>* SourceAttribute = static_cast<const FPCGMetadataAttribute<AttributeType>*>(Operation.SourceAttribute);
+			FPCGMetadataAttribute<AttributeType>* TargetAttribute = static_cast<FPCGMetadataAttribute<AttributeType>*>(Operation.TargetAttribute);
+			TArray<PCGMetadataValueKey>& ValueKeyRemap = Operation.ValueKeyRemap;
+
+			for (PCGMetadataValueKey& ValueKey : InOutValueKeys)
 			{
-				if (!DataItem || DataItem->IsA(DataType::StaticClass()))
+				// The default value was copied with the attribute
+				if (ValueKey == PCGDefaultValueKey)
 				{
-					return false;
+					continue;
+				}
+
+				PCGMetadataValueKey& TargetValueKey = ValueKeyRemap[ValueKey];
+				if (TargetValueKey == UnmappedValueKey)
+				{
+					TargetValueKey = TargetAttribute->AddValue(SourceAttribute->GetValue(ValueKey));
 				}
+
+				ValueKey = TargetValueKey;
 			}
+
 			return true;
+		};
+
+		PCGMetadataAttribute::CallbackWithRightType(Operation.SourceAttribute->GetTypeId(), Remap);
+	}
+
+	/** Values of trivial types are kept in pooled scratch arrays, given back once the operation is done with them. */
+	template <typename T>
+	struct TSourceColumn : public FPCGCopyAttributeSourceColumn
+	{
+		TArray<T> Values;
+
+		explicit TSourceColumn(int32 InNum)
+		{
+			if constexpr (std::is_trivially_copyable_v<T>)
+			{
+				Values = TScratchPool<T>::Acquire(InNum);
+				FMemory::Memzero(Values.GetData(), Values.Num() * sizeof(T));
+			}
+			else
+			{
+				Values.SetNum(InNum);
+			}
+		}
+
+		virtual ~TSourceColumn() override
+		{
+			if constexpr (std::is_trivially_copyable_v<T>)
+			{
+				TScratchPool<T>::Release(MoveTemp(Values));
+			}
 		}
 	};
+
+	/** Keeps the indices in [InStart, InEnd) for which the predicate is true, in order, each batch being filtered by its own task. */
+	template <typename PredicateType>
+	void ParallelFilterIndices(int32 InStart, int32 InEnd, int32 InBatchSize, TArray<int32>& OutIndices, PredicateType&& InPredicate)
+	{
+		OutIndices.Reset();
+
+		const int32 NumBatches = FMath::DivideAndRoundUp(InEnd - InStart, InBatchSize);
+		if (NumBatches <= 0)
+		{
+			return;
+		}
+
+		TArray<int32> BatchOffsets;
+		BatchOffsets.SetNumZeroed(NumBatches + 1);
+
+		ParallelFor(NumBatches, [&BatchOffsets, &InPredicate, InStart, InEnd, InBatchSize](int32 BatchIdx)
+		{
+			const int32 Start = InStart + BatchIdx * InBatchSize;
+			const int32 End = FMath::Min(Start + InBatchSize, InEnd);
+
+			int32 Count = 0;
+			for (int32 Idx = Start; Idx < End; ++Idx)
+			{
+				Count += InPredicate(Idx) ? 1 : 0;
+			}
+
+			BatchOffsets[BatchIdx + 1] = Count;
+		});
+
+		for (int32 BatchIdx = 0; BatchIdx < NumBatches; ++BatchIdx)
+		{
+			BatchOffsets[BatchIdx + 1] += BatchOffsets[BatchIdx];
+		}
+
+		OutIndices.SetNumUninitialized(BatchOffsets[NumBatches], EAllowShrinking::No);
+
+		ParallelFor(NumBatches, [&BatchOffsets, &OutIndices, &InPredicate, InStart, InEnd, InBatchSize](int32 BatchIdx)
+		{
+			const int32 Start = InStart + BatchIdx * InBatchSize;
+			const int32 End = FMath::Min(Start + InBatchSize, InEnd);
+
+			int32* Out = OutIndices.GetData() + BatchOffsets[BatchIdx];
+			for (int32 Idx = Start; Idx < End; ++Idx)
+			{
+				if (InPredicate(Idx))
+				{
+					*Out++ = Idx;
+				}
+			}
+		});
+	}
+
+	/** Gives an entry of its own to each written point that needs one, with a single bulk call. New entries are parented to the ones the points had. */
+	void InitializeEntries(UPCGPointData* OutPointData, const TArray<int32>* InTargetToSource, bool bInInheritEntries, int32 InBatchSize)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(FPCGCopyAttributeElement::InitializeEntries);
+
+		TArray<FPCGPoint>& Points = OutPointData->GetMutablePoints();
+
+		// Keys below this one belong to the parent metadata
+		const UPCGMetadata* ParentMetadata = OutPointData->Metadata->GetParent();
+		const PCGMetadataEntryKey FirstOwnEntryKey = ParentMetadata ? ParentMetadata->GetItemKeyCountForParent() : 0;
+
+		auto IsWritten = [InTargetToSource](int32 PointIdx)
+		{
+			return !InTargetToSource || (*InTargetToSource)[PointIdx] != INDEX_NONE;
+		};
+
+		// Inherited entries still resolve through the parent metadata, so only points without any entry need one
+		auto NeedsEntry = [FirstOwnEntryKey, bInInheritEntries](PCGMetadataEntryKey Key)
+		{
+			return Key == PCGInvalidEntryKey || (!bInInheritEntries && Key < FirstOwnEntryKey);
+		};
+
+		TArray<int32> PointsToInitialize = TScratchPool<int32>::Acquire(Points.Num());
+		ParallelFilterIndices(0, Points.Num(), InBatchSize, PointsToInitialize, [&Points, &IsWritten, &NeedsEntry](int32 PointIdx)
+		{
+			return IsWritten(PointIdx) && NeedsEntry(Points[PointIdx].MetadataEntry);
+		});
+
+		// Points sharing an entry would all get the value written last, so all but the first one get their own
+		TBitArray<> UsedEntries(false, IntCastChecked<int32>(OutPointData->Metadata->GetItemCountForChild()));
+		for (int32 PointIdx = 0; PointIdx < Points.Num(); ++PointIdx)
+		{
+			const PCGMetadataEntryKey Key = Points[PointIdx].MetadataEntry;
+			if (!IsWritten(PointIdx) || NeedsEntry(Key))
+			{
+				continue;
+			}
+
+			FBitReference bUsed = UsedEntries[static_cast<int32>(Key)];
+			if (bUsed)
+			{
+				PointsToInitialize.Add(PointIdx);
+			}
+			else
+			{
+				bUsed = true;
+			}
+		}
+
+		if (!PointsToInitialize.IsEmpty())
+		{
+			TArray<PCGMetadataEntryKey*> KeysToInitialize;
+			KeysToInitialize.SetNumUninitialized(PointsToInitialize.Num());
+
+			ParallelFor(FMath::DivideAndRoundUp(PointsToInitialize.Num(), InBatchSize), [&Points, &PointsToInitialize, &KeysToInitialize, InBatchSize](int32 BatchIdx)
+			{
+				const int32 Start = BatchIdx * InBatchSize;
+				const int32 End = FMath::Min(Start + InBatchSize, PointsToInitialize.Num());
+				for (int32 Idx = Start; Idx < End; ++Idx)
+				{
+					KeysToInitialize[Idx] = &Points[PointsToInitialize[Idx]].MetadataEntry;
+				}
+			});
+
+			OutPointData->Metadata->AddEntriesInPlace(KeysToInitialize);
+		}
+
+		TScratchPool<int32>::Release(MoveTemp(PointsToInitialize));
+	}
+
+	/** Counts the points written by a slice of an operation, for the stats and the debug info. */
+	void CountCopied(FPCGCopyAttributeTarget& Target, int32 InNumPoints, int32 InValueSize)
+	{
+		const int64 Bytes = static_cast<int64>(InNumPoints) * InValueSize;
+		Target.BytesCopied += Bytes;
+
+		INC_DWORD_STAT_BY(STAT_PCGPlus_PointsCopied, InNumPoints);
+		INC_MEMORY_STAT_BY(STAT_PCGPlus_BytesCopied, Bytes);
+	}
+
+	/** Describes how the target was copied, through attributes of its output that only have a default value. */
+	void AddDebugInfo(const FPCGCopyAttributeTarget& Target, EPCGCopyAttributeMatchMode InMatchMode)
+	{
+		UPCGMetadata* Metadata = Target.OutputSpatialData->Metadata;
+		check(Metadata);
+
+		int32 NumDirect = 0;
+		for (const FPCGCopyAttributeOperation& Operation : Target.Operations)
+		{
+			NumDirect += Operation.IsDirect() ? 1 : 0;
+		}
+
+		const int32 NumAccessor = Target.Operations.Num() - NumDirect;
+		const int32 NumPaths = (NumDirect > 0 ? 1 : 0) + (NumAccessor > 0 ? 1 : 0) + (Target.NumMoved > 0 ? 1 : 0);
+
+		FName CopyPath = TEXT("None");
+		if (NumPaths > 1)
+		{
+			CopyPath = TEXT("Mixed");
+		}
+		else if (NumDirect > 0)
+		{
+			CopyPath = TEXT("DirectAttribute");
+		}
+		else if (NumAccessor > 0)
+		{
+			CopyPath = TEXT("Accessor");
+		}
+		else if (Target.NumMoved > 0)
+		{
+			CopyPath = TEXT("Moved");
+		}
+
+		FName MatchPath = TEXT("Index");
+		if (Target.bSample)
+		{
+			MatchPath = TEXT("Sample");
+		}
+		else if (Target.MatchResult.IsValid())
+		{
+			if (Target.bMatchFromCache)
+			{
+				MatchPath = TEXT("Cached");
+			}
+			else if (InMatchMode == EPCGCopyAttributeMatchMode::Nearest)
+			{
+				MatchPath = TEXT("Nearest");
+			}
+			else if (InMatchMode == EPCGCopyAttributeMatchMode::Range)
+			{
+				MatchPath = TEXT("Range");
+			}
+			else
+			{
+				MatchPath = TEXT("Attribute");
+			}
+		}
+
+		const int32 NumPoints = CastChecked<UPCGPointData>(Target.TargetSpatialData)->GetPoints().Num();
+		const int32 NumMatched = Target.MatchResult.IsValid() ? Target.MatchResult->NumMatched : NumPoints;
+		const int32 NumUnmatched = Target.MatchResult.IsValid() ? Target.MatchResult->NumUnmatched : 0;
+
+		Metadata->CreateAttribute<FName>(TEXT("PCGPlus_CopyPath"), CopyPath, /*bAllowsInterpolation=*/false, /*bOverrideParent=*/true);
+		Metadata->CreateAttribute<FName>(TEXT("PCGPlus_MatchPath"), MatchPath, /*bAllowsInterpolation=*/false, /*bOverrideParent=*/true);
+		Metadata->CreateAttribute<int32>(TEXT("PCGPlus_MatchedPoints"), NumMatched, /*bAllowsInterpolation=*/false, /*bOverrideParent=*/true);
+		Metadata->CreateAttribute<int32>(TEXT("PCGPlus_UnmatchedPoints"), NumUnmatched, /*bAllowsInterpolation=*/false, /*bOverrideParent=*/true);
+		Metadata->CreateAttribute<int64>(TEXT("PCGPlus_BytesCopied"), Target.BytesCopied, /*bAllowsInterpolation=*/false, /*bOverrideParent=*/true);
+		Metadata->CreateAttribute<double>(TEXT("PCGPlus_Milliseconds"), Target.ExecutionSeconds * 1000.0, /*bAllowsInterpolation=*/false, /*bOverrideParent=*/true);
+	}
 }
 
 #if WITH_EDITOR
@@ -89,8 +719,14 @@ FText UPCGCopyAttributeSettings::GetNodeTooltipText() const
 EPCGDataType UPCGCopyAttributeSettings::GetCurrentPinTypes(const UPCGPin* InPin) const
 {
 	// All pins narrow to same type, which is Point if any input is Point, otherwise Spatial
-	const bool bAnyArePoint = (GetTypeUnionOfIncidentEdges(UE::PCGPlus::Private::TargetLabel) == EPCGDataType::Point)
-							|| (GetTypeUnionOfIncidentEdges(UE::PCGPlus::Private::SourceLabel) == EPCGDataType::Point);
+	const bool bSourceIsPoint = GetTypeUnionOfIncidentEdges(UE::PCGPlus::Private::SourceLabel) == EPCGDataType::Point;
+	const bool bAnyArePoint = bSourceIsPoint || (GetTypeUnionOfIncidentEdges(UE::PCGPlus::Private::TargetLabel) == EPCGDataType::Point);
+
+	// Except for the source, which can be any spatial data sampled at the target points
+	if (InPin && !InPin->IsOutputPin() && InPin->Properties.Label == UE::PCGPlus::Private::SourceLabel)
+	{
+		return bSourceIsPoint ? EPCGDataType::Point : EPCGDataType::Spatial;
+	}
 
 	return bAnyArePoint ? EPCGDataType::Point : EPCGDataType::Spatial;
 }
@@ -100,26 +736,34 @@ FName UPCGCopyAttributeSettings::AdditionalTaskName() const
 	const FName SourceAttributeName = SourceAttributeProperty.GetName();
 	const FName TargetAttributeName = TargetAttributeProperty.GetName();
 
+	FString TaskName;
 	if (SourceAttributeName != TargetAttributeName && TargetAttributeName != NAME_None)
 	{
-		return FName(FString::Printf(TEXT("%s %s to %s"),
+		TaskName = FString::Printf(TEXT("%s %s to %s"),
 			*UE::PCGPlus::Private::NodeName.ToString(),
 			*SourceAttributeName.ToString(),
-			*TargetAttributeName.ToString()));
+			*TargetAttributeName.ToString());
 	}
 	else
 	{
-		return FName(FString::Printf(TEXT("%s %s"),
+		TaskName = FString::Printf(TEXT("%s %s"),
 			*UE::PCGPlus::Private::NodeName.ToString(),
-			*SourceAttributeName.ToString()));
+			*SourceAttributeName.ToString());
+	}
+
+	if (!AdditionalMappings.IsEmpty())
+	{
+		TaskName += FString::Printf(TEXT(" (+%d)"), AdditionalMappings.Num());
 	}
+
+	return FName(TaskName);
 }
 
 TArray<FPCGPinProperties> UPCGCopyAttributeSettings::InputPinProperties() const
 {
 	TArray<FPCGPinProperties> PinProperties;
-	PinProperties.Emplace(UE::PCGPlus::Private::TargetLabel, EPCGDataType::Spatial, /*bInAllowMultipleConnections=*/ false);
-	PinProperties.Emplace(UE::PCGPlus::Private::SourceLabel, EPCGDataType::Spatial, /*bInAllowMultipleConnections=*/ false);
+	PinProperties.Emplace(UE::PCGPlus::Private::TargetLabel, EPCGDataType::Spatial, /*bInAllowMultipleConnections=*/ true);
+	PinProperties.Emplace(UE::PCGPlus::Private::SourceLabel, EPCGDataType::Spatial, /*bInAllowMultipleConnections=*/ true);
 
 	return PinProperties;
 }
@@ -137,66 +781,441 @@ FPCGElementPtr UPCGCopyAttributeSettings::CreateElement() const
 	return MakeShared<FPCGCopyAttributeElement>();
 }
 
-bool FPCGCopyAttributeElement::ExecuteInternal(FPCGContext* Context) const
+void UPCGCopyAttributeSettings::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	Ar.UsingCustomVersion(FPCGPlusCustomVersion::GUID);
+}
+
+void UPCGCopyAttributeSettings::PostLoad()
+{
+	Super::PostLoad();
+
+#if WITH_EDITORONLY_DATA
+	// Older assets did not save MatchMode, so it must not be left to its current default
+	if (GetLinkerCustomVersion(FPCGPlusCustomVersion::GUID) < FPCGPlusCustomVersion::CopyAttributeMatchMode)
+	{
+		MatchMode = bMatchByAttribute_DEPRECATED ? EPCGCopyAttributeMatchMode::Attribute : EPCGCopyAttributeMatchMode::Index;
+		bMatchByAttribute_DEPRECATED = true;
+	}
+#endif
+}
+
+FPCGContext* FPCGCopyAttributeElement::Initialize(const FPCGDataCollection& InputData, TWeakObjectPtr<UPCGComponent> SourceComponent, const UPCGNode* Node)
+{
+	FPCGCopyAttributeContext* Context = new FPCGCopyAttributeContext();
+	Context->InputData = InputData;
+	Context->SourceComponent = SourceComponent;
+	Context->Node = Node;
+
+	return Context;
+}
+
+bool FPCGCopyAttributeElement::ExecuteInternal(FPCGContext* InContext) const
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(FPCGCopyAttributeElement::Execute);
 
+	FPCGCopyAttributeContext* Context = static_cast<FPCGCopyAttributeContext*>(InContext);
 	check(Context);
 
+	if (!Context->bPaired)
+	{
+		UE::PCGPlus::Private::PairInputs(Context);
+		Context->bPaired = true;
+	}
+
 	const UPCGCopyAttributeSettings* Settings = Context->GetInputSettings<UPCGCopyAttributeSettings>();
 	check(Settings);
 
-	TArray<FPCGTaggedData> SourceInputs = Context->InputData.GetInputsByPin(UE::PCGPlus::Private::SourceLabel);
-	TArray<FPCGTaggedData> TargetInputs = Context->InputData.GetInputsByPin(UE::PCGPlus::Private::TargetLabel);
+	// At least one step runs per execution, so the copy always makes progress
+	bool bProgressed = false;
 
-	if (SourceInputs.Num() != 1 || TargetInputs.Num() != 1)
+	while (Context->CurrentBatch < Context->Batches.Num())
 	{
-		PCGE_LOG(Warning, LogOnly, FText::Format(LOCTEXT("WrongNumberOfInputs", "Source input contains {0} data elements, Target inputs contain {1} data elements, but both should contain precisely 1 data element"), SourceInputs.Num(), TargetInputs.Num()));
-		return true;
+		// A stale component drops the batches not started yet. A started batch still goes through the rounds below, which abort its pending targets and remove their outputs.
+		if (!Context->bPrepared && Context->SourceComponent.IsStale())
+		{
+			break;
+		}
+
+		if (!Context->bPrepared)
+		{
+			SCOPE_CYCLE_COUNTER(STAT_PCGPlus_CopyAttribute_Prepare);
+			PrepareCopy(Context);
+			Context->bPrepared = true;
+			bProgressed = true;
+		}
+
+		// Each round runs the next slice of every pending target concurrently. The time budget is only checked between rounds.
+		TArray<FPCGCopyAttributeTarget*> PendingTargets;
+		for (;;)
+		{
+			PendingTargets.Reset();
+			for (FPCGCopyAttributeTarget& Target : Context->Targets)
+			{
+				if (Target.Stage != EPCGCopyAttributeStage::Done)
+				{
+					PendingTargets.Add(&Target);
+				}
+			}
+
+			if (PendingTargets.IsEmpty())
+			{
+				break;
+			}
+
+			if (bProgressed && Context->ShouldStop())
+			{
+				return false;
+			}
+
+			if (Context->SourceComponent.IsStale())
+			{
+				for (FPCGCopyAttributeTarget* Target : PendingTargets)
+				{
+					UE::PCGPlus::Private::AbortTarget(*Target);
+				}
+
+				break;
+			}
+
+			if (PendingTargets.Num() > 1)
+			{
+				ParallelFor(PendingTargets.Num(), [this, Context, &PendingTargets](int32 TargetIndex)
+				{
+					ExecuteTarget(Context, *PendingTargets[TargetIndex]);
+				});
+			}
+			else
+			{
+				ExecuteTarget(Context, *PendingTargets[0]);
+			}
+
+			UE::PCGPlus::Private::LogTargetMessages(Context);
+			bProgressed = true;
+		}
+
+		// Outputs of failed targets cannot be removed from the worker threads
+		for (const FPCGCopyAttributeTarget& Target : Context->Targets)
+		{
+			if (Target.bAborted && Target.OutputSpatialData)
+			{
+				Context->OutputData.TaggedData.RemoveAll([&Target](const FPCGTaggedData& TaggedData) { return TaggedData.Data == Target.OutputSpatialData; });
+			}
+			else if (Settings->bOutputDebugInfo && Target.OutputSpatialData && (Context->SourcePointData || Target.bSample))
+			{
+				UE::PCGPlus::Private::AddDebugInfo(Target, Settings->MatchMode);
+			}
+		}
+
+		UE::PCGPlus::Private::NextBatch(Context);
+	}
+
+	return true;
+}
+
+void FPCGCopyAttributeElement::ExecuteTarget(FPCGCopyAttributeContext* Context, FPCGCopyAttributeTarget& Target) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FPCGCopyAttributeElement::ExecuteTarget);
+
+	const double StartTime = FPlatformTime::Seconds();
+	ON_SCOPE_EXIT
+	{
+		Target.ExecutionSeconds += FPlatformTime::Seconds() - StartTime;
+	};
+
+	if (Target.Stage == EPCGCopyAttributeStage::Match)
+	{
+		// The copy starts on the next round, as the match may have used up the slice
+		MatchPoints(Context, Target);
+		return;
+	}
+
+	if (Target.Stage == EPCGCopyAttributeStage::Copy && Target.CurrentOperation < Target.Operations.Num())
+	{
+		FPCGCopyAttributeOperation& Operation = Target.Operations[Target.CurrentOperation];
+
+		const bool bOperationDone = Operation.IsDirect() ? CopyValueKeys(Context, Target, Operation) : CopyValues(Context, Target, Operation);
+		if (!bOperationDone)
+		{
+			return;
+		}
+
+		// The operation may also have aborted the copy
+		if (Target.Stage == EPCGCopyAttributeStage::Copy)
+		{
+			Target.CurrentIndex = 0;
+			++Target.CurrentOperation;
+		}
+
+		// The next operation starts on the next round
+		if (Target.Stage == EPCGCopyAttributeStage::Copy && Target.CurrentOperation < Target.Operations.Num())
+		{
+			return;
+		}
+	}
+
+	if (Target.Stage == EPCGCopyAttributeStage::Copy)
+	{
+		Target.Stage = EPCGCopyAttributeStage::Done;
+	}
+
+	if (!Target.bAborted && Target.MatchResult.IsValid() && Target.MatchResult->NumUnmatched > 0)
+	{
+		const UPCGCopyAttributeSettings* Settings = Context->GetInputSettings<UPCGCopyAttributeSettings>();
+		check(Settings);
+
+		if (Settings->JoinMode == EPCGCopyAttributeJoinMode::Inner)
+		{
+			SCOPE_CYCLE_COUNTER(STAT_PCGPlus_CopyAttribute_RemoveUnmatched);
+			TRACE_CPUPROFILER_EVENT_SCOPE(FPCGCopyAttributeElement::RemoveUnmatchedPoints);
+			RemoveUnmatchedPoints(Target);
+		}
 	}
-	
-	FPCGTaggedData& SourceInput = SourceInputs[0];
-	FPCGTaggedData& TargetInput = TargetInputs[0];
+}
+
+void FPCGCopyAttributeElement::PrepareCopy(FPCGCopyAttributeContext* Context) const
+{
+	const UPCGCopyAttributeSettings* Settings = Context->GetInputSettings<UPCGCopyAttributeSettings>();
+	check(Settings);
 
-	// UE::PCGPlus::Private::TPCGDataTypeConstraint<UPCGSpatialData> SpatialDataConstraint;
-	// if (!UE::PCGPlus::Private::TPCGDataTypeConstraint<UPCGSpatialData>::All({ SourceInput.Data, TargetInput.Data }))
-	// {
-	// 	if (!UE::PCGPlus::Private::TPCGDataTypeConstraint<UPCGPointData>::All({ SourceInput.Data, TargetInput.Data }))
-	// 	{
-	// 		PCGE_LOG(Error, GraphAndLog, LOCTEXT("UnsupportedTypes", "Only supports Spatial to Spatial data or Point to Point data"));
-	// 		return true;
-	// 	}
-	// }
+	const FPCGCopyAttributeBatch& Batch = Context->Batches[Context->CurrentBatch];
+	const TArray<FPCGTaggedData> SourceInputs = Context->InputData.GetInputsByPin(UE::PCGPlus::Private::SourceLabel);
+	const TArray<FPCGTaggedData> TargetInputs = Context->InputData.GetInputsByPin(UE::PCGPlus::Private::TargetLabel);
 
-	const UPCGSpatialData* SourceSpatialData = Cast<const UPCGSpatialData>(SourceInputs[0].Data);
-	const UPCGSpatialData* TargetSpatialData = Cast<const UPCGSpatialData>(TargetInputs[0].Data);
+	const FPCGTaggedData& SourceInput = SourceInputs[Batch.SourceInputIndex];
 
-	if (!SourceSpatialData
-		|| !TargetSpatialData
-		|| SourceSpatialData->IsA<UPCGPointData>() != TargetSpatialData->IsA<UPCGPointData>())
+	const UPCGSpatialData* SourceSpatialData = Cast<const UPCGSpatialData>(SourceInput.Data);
+	if (!SourceSpatialData)
 	{
 		PCGE_LOG(Error, GraphAndLog, LOCTEXT("UnsupportedTypes", "Only supports Spatial to Spatial data or Point to Point data"));
-		return true;
+		return;
+	}
+
+	if (!SourceSpatialData->Metadata)
+	{
+		PCGE_LOG(Error, GraphAndLog, LOCTEXT("SourceMissingMetadata", "Source does not have metadata"));
+		return;
 	}
 
 	const UPCGPointData* SourcePointData = Cast<const UPCGPointData>(SourceSpatialData);
-	const UPCGPointData* TargetPointData = Cast<const UPCGPointData>(TargetSpatialData);
 
-	const bool bIsPointData = SourcePointData && TargetPointData;
-	if (bIsPointData && SourcePointData->GetPoints().Num() != TargetPointData->GetPoints().Num())
+	Context->SourceSpatialData = SourceSpatialData;
+	Context->SourcePointData = SourcePointData;
+
+	// Targets failing validation are skipped, the others are still copied to
+	Context->Targets.Reserve(Batch.TargetInputIndices.Num());
+	for (const int32 TargetInputIndex : Batch.TargetInputIndices)
 	{
-		PCGE_LOG(Error, GraphAndLog, LOCTEXT("MismatchingPointCounts", "Source and target do not have the same number of points"));
-		return true;
+		const FPCGTaggedData& TargetInput = TargetInputs[TargetInputIndex];
+		const UPCGSpatialData* TargetSpatialData = Cast<const UPCGSpatialData>(TargetInput.Data);
+
+		// Target points are sampled from a source that is not points, or when asked to
+		const UPCGPointData* TargetPointData = Cast<const UPCGPointData>(TargetSpatialData);
+		const bool bSample = TargetPointData && (!SourcePointData || Settings->MatchMode == EPCGCopyAttributeMatchMode::Sample);
+
+		if (!TargetSpatialData || (SourcePointData && !TargetPointData))
+		{
+			PCGE_LOG(Error, GraphAndLog, LOCTEXT("UnsupportedTypes", "Only supports Spatial to Spatial data or Point to Point data"));
+			continue;
+		}
+
+		// Points are paired by index when not matching, which needs as many on both sides
+		if (SourcePointData && Settings->MatchMode == EPCGCopyAttributeMatchMode::Index && SourcePointData->GetPoints().Num() != TargetPointData->GetPoints().Num())
+		{
+			PCGE_LOG(Error, GraphAndLog, LOCTEXT("MismatchingPointCounts", "Source and target do not have the same number of points"));
+			continue;
+		}
+
+		UPCGSpatialData* OutputData = nullptr;
+		{
+			SCOPE_CYCLE_COUNTER(STAT_PCGPlus_CopyAttribute_Duplicate);
+			TRACE_CPUPROFILER_EVENT_SCOPE(FPCGCopyAttributeElement::DuplicateData);
+			OutputData = TargetSpatialData->DuplicateData();
+		}
+
+		check(OutputData->Metadata);
+
+		// Registered right away, so it is kept alive while time slicing. It is removed if the copy fails.
+		FPCGTaggedData& Output = Context->OutputData.TaggedData.Add_GetRef(TargetInput);
+		Output.Data = OutputData;
+
+		FPCGCopyAttributeTarget& Target = Context->Targets.Emplace_GetRef();
+		Target.TargetSpatialData = TargetSpatialData;
+		Target.OutputSpatialData = OutputData;
+
+		if (bSample)
+		{
+			if (!Context->SampleData.IsValid())
+			{
+				UPCGPointData* SampleData = NewObject<UPCGPointData>();
+				SampleData->InitializeFromData(SourceSpatialData);
+				Context->SampleData.Reset(SampleData);
+			}
+
+			Target.bSample = true;
+			Target.SampledPoints.SetNumUninitialized(TargetPointData->GetPoints().Num());
+		}
+
+		// All mappings share the output, so an error on any of them fails the whole target
+		bool bSuccess = PrepareOperation(Context, Target, Settings->SourceAttributeProperty, Settings->TargetAttributeProperty);
+		for (int32 MappingIndex = 0; bSuccess && MappingIndex < Settings->AdditionalMappings.Num(); ++MappingIndex)
+		{
+			const FPCGCopyAttributeMapping& Mapping = Settings->AdditionalMappings[MappingIndex];
+			bSuccess = PrepareOperation(Context, Target, Mapping.SourceAttributeProperty, Mapping.TargetAttributeProperty);
+		}
+
+		// Even without anything to copy, an inner join still has to drop the unmatched points
+		Target.Stage = EPCGCopyAttributeStage::Copy;
+		if (!bSuccess)
+		{
+			UE::PCGPlus::Private::AbortTarget(Target);
+		}
+		else if (bSample)
+		{
+			// Samples are written to points and entries of their own, so they are never cached
+			Target.MatchTask = MakeUnique<UE::PCGPlus::Private::FSampleTask>(SourceSpatialData, TargetPointData, Context->SampleData->Metadata, Target.SampledPoints, Settings->BatchSize);
+			Target.Stage = EPCGCopyAttributeStage::Match;
+		}
+	}
+
+	if (!SourcePointData || Settings->MatchMode == EPCGCopyAttributeMatchMode::Index || Settings->MatchMode == EPCGCopyAttributeMatchMode::Sample)
+	{
+		return;
+	}
+
+	const bool bMatchNearest = Settings->MatchMode == EPCGCopyAttributeMatchMode::Nearest;
+	const bool bMatchRange = Settings->MatchMode == EPCGCopyAttributeMatchMode::Range;
+	const double MaxDistance = Settings->bUseMaxDistance ? Settings->MaxDistance : -1.0;
+
+	const TArray<FPCGAttributePropertyInputSelector> SourceMatchSelectors = UE::PCGPlus::GetKeySelectors(Settings->SourceMatchAttributeProperty, Settings->AdditionalMatchKeys, &FPCGCopyAttributeMatchKey::SourceMatchAttributeProperty);
+	const TArray<FPCGAttributePropertyInputSelector> TargetMatchSelectors = UE::PCGPlus::GetKeySelectors(Settings->TargetMatchAttributeProperty, Settings->AdditionalMatchKeys, &FPCGCopyAttributeMatchKey::TargetMatchAttributeProperty);
+
+	// Aggregates are stored on the first source point of each group, so that is the one targets are matched with
+	const bool bAggregate = UE::PCGPlus::Private::IsAggregating(Context, Settings);
+	Context->DuplicatePolicy = bAggregate ? UE::PCGPlus::EJoinDuplicatePolicy::First : UE::PCGPlus::Private::GetJoinDuplicatePolicy(Settings->DuplicatePolicy);
+
+	// Targets whose match is not in the cache are matched together, so they can share the index over the source
+	TArray<FPCGCopyAttributeTarget*> TargetsToMatch;
+	for (FPCGCopyAttributeTarget& Target : Context->Targets)
+	{
+		if (Target.Stage != EPCGCopyAttributeStage::Copy)
+		{
+			continue;
+		}
+
+		if (Settings->bCacheMatch)
+		{
+			Target.MatchCacheKey.SourceUID = SourcePointData->UID;
+			Target.MatchCacheKey.TargetUID = Target.TargetSpatialData->UID;
+
+			if (bMatchNearest)
+			{
+				// Nearest matches only depend on the positions, and on the exact max distance
+				Target.MatchCacheKey.SourceSelector = TEXT("$Position");
+				Target.MatchCacheKey.TargetSelector = FString::Printf(TEXT("$Position<%.17g"), MaxDistance);
+			}
+			else if (bMatchRange)
+			{
+				// Range matches depend on how the source ranges are made, and only on the main match keys
+				const FString SourceSelector = UE::PCGPlus::GetKeySelectorsString(SourcePointData, MakeArrayView(&Settings->SourceMatchAttributeProperty, 1));
+				Target.MatchCacheKey.SourceSelector = Settings->RangeMode == EPCGCopyAttributeRangeMode::Interval
+					? FString::Printf(TEXT("%s..%s"), *SourceSelector, *UE::PCGPlus::GetKeySelectorsString(SourcePointData, MakeArrayView(&Settings->SourceRangeMaxAttributeProperty, 1)))
+					: FString::Printf(TEXT("%s+-%.17g"), *SourceSelector, Settings->MatchTolerance);
+				Target.MatchCacheKey.TargetSelector = UE::PCGPlus::GetKeySelectorsString(Target.TargetSpatialData, MakeArrayView(&Settings->TargetMatchAttributeProperty, 1));
+				Target.MatchCacheKey.DuplicatePolicy = Context->DuplicatePolicy;
+			}
+			else
+			{
+				Target.MatchCacheKey.SourceSelector = UE::PCGPlus::GetKeySelectorsString(SourcePointData, SourceMatchSelectors);
+				Target.MatchCacheKey.TargetSelector = UE::PCGPlus::GetKeySelectorsString(Target.TargetSpatialData, TargetMatchSelectors);
+				Target.MatchCacheKey.DuplicatePolicy = Context->DuplicatePolicy;
+			}
+
+			Target.MatchResult = UE::PCGPlus::FJoinCache::Get().Find(Target.MatchCacheKey);
+			if (Target.MatchResult.IsValid())
+			{
+				Target.bMatchFromCache = true;
+				INC_DWORD_STAT(STAT_PCGPlus_CachedMatches);
+				INC_DWORD_STAT_BY(STAT_PCGPlus_PointsMatched, Target.MatchResult->NumMatched);
+				INC_DWORD_STAT_BY(STAT_PCGPlus_PointsUnmatched, Target.MatchResult->NumUnmatched);
+				continue;
+			}
+		}
+
+		TargetsToMatch.Add(&Target);
 	}
 
-	if (!SourceSpatialData->Metadata)
-	{
-		PCGE_LOG(Error, GraphAndLog, LOCTEXT("SourceMissingMetadata", "Source does not have metadata"));
-		return true;
-	}
+	if (bMatchNearest)
+	{
+		if (!TargetsToMatch.IsEmpty())
+		{
+			UE::PCGPlus::Private::CreateNearestMatchTasks(Context, TargetsToMatch, MaxDistance);
+		}
+
+		return;
+	}
+
+	if (bMatchRange)
+	{
+		if (!TargetsToMatch.IsEmpty())
+		{
+			UE::PCGPlus::Private::CreateRangeMatchTasks(Context, Settings, TargetsToMatch);
+		}
+
+		return;
+	}
+
+	if (TargetsToMatch.IsEmpty() && !bAggregate)
+	{
+		return;
+	}
+
+	// The source keys are read once, for all the joins and the aggregation groups
+	bool bSourceKeysRead = false;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_PCGPlus_CopyAttribute_ReadKeys);
+		bSourceKeysRead = Context->SourceMatchKeys.Read(Context, SourcePointData, SourceMatchSelectors);
+	}
+
+	if (!bSourceKeysRead)
+	{
+		for (FPCGCopyAttributeTarget& Target : Context->Targets)
+		{
+			UE::PCGPlus::Private::AbortTarget(Target);
+		}
+
+		return;
+	}
+
+	if (bAggregate)
+	{
+		UE::PCGPlus::GroupKeys(Context->SourceMatchKeys, Context->SourceGroups);
+	}
+
+	if (!TargetsToMatch.IsEmpty())
+	{
+		UE::PCGPlus::Private::CreateMatchTasks(Context, TargetsToMatch, TargetMatchSelectors);
+	}
+}
+
+bool FPCGCopyAttributeElement::PrepareOperation(FPCGCopyAttributeContext* Context, FPCGCopyAttributeTarget& Target, const FPCGAttributePropertyInputSelector& InSourceAttributeProperty, const FPCGAttributePropertyOutputSelector& InTargetAttributeProperty) const
+{
+	const UPCGSpatialData* SourceSpatialData = Context->SourceSpatialData;
+	const UPCGSpatialData* TargetSpatialData = Target.TargetSpatialData;
+	UPCGSpatialData* OutputData = Target.OutputSpatialData;
+	const bool bIsPointData = Context->SourcePointData != nullptr;
+	const bool bSample = Target.bSample;
+
+	const UPCGCopyAttributeSettings* Settings = Context->GetInputSettings<UPCGCopyAttributeSettings>();
+	check(Settings);
+
+	// Aggregates are computed on values, so they go through accessors even between plain attributes
+	const bool bAggregate = UE::PCGPlus::Private::IsAggregating(Context, Settings);
 
-	const FPCGAttributePropertyInputSelector SourceAttributeProperty = Settings->SourceAttributeProperty.CopyAndFixLast(SourceSpatialData);
-	const FPCGAttributePropertyOutputSelector TargetAttributeProperty = Settings->TargetAttributeProperty.CopyAndFixSource(&SourceAttributeProperty, SourceSpatialData);
+	const FPCGAttributePropertyInputSelector SourceAttributeProperty = InSourceAttributeProperty.CopyAndFixLast(SourceSpatialData);
+	const FPCGAttributePropertyOutputSelector TargetAttributeProperty = InTargetAttributeProperty.CopyAndFixSource(&SourceAttributeProperty, SourceSpatialData);
 
 	const FName SourceAttributeName = SourceAttributeProperty.GetName();
 	const FName TargetAttributeName = TargetAttributeProperty.GetName();
@@ -204,209 +1223,91 @@ bool FPCGCopyAttributeElement::ExecuteInternal(FPCGContext* Context) const
 	if (SourceAttributeProperty.GetSelection() == EPCGAttributePropertySelection::Attribute && !SourceSpatialData->Metadata->HasAttribute(SourceAttributeName))
 	{
 		PCGE_LOG(Error, GraphAndLog, FText::Format(LOCTEXT("SourceMissingAttribute", "Source does not have the attribute '{0}'"), FText::FromName(SourceAttributeName)));
-		return true;
+		return false;
 	}
 
-	UPCGSpatialData* OutputData = TargetSpatialData->DuplicateData();
-	check(OutputData->Metadata);
-
-	auto AppendOutputData = [Context, OutputData]()
-	{
-		TArray<FPCGTaggedData>& Outputs = Context->OutputData.TaggedData;
-		FPCGTaggedData& Output = Outputs.Emplace_GetRef();
-		Output.Data = OutputData;
-	};
-
 	// If it is attribute to attribute, just copy the attributes, if they exist and are valid
 	// Only do that if it is really attribute to attribute, without any extra accessor. Any extra accessor will behave as a property.
 	const bool bInputHasAnyExtra = !SourceAttributeProperty.GetExtraNames().IsEmpty();
 	const bool bOutputHasAnyExtra = !TargetAttributeProperty.GetExtraNames().IsEmpty();
-	if (!bInputHasAnyExtra && !bOutputHasAnyExtra && SourceAttributeProperty.GetSelection() == EPCGAttributePropertySelection::Attribute && TargetAttributeProperty.GetSelection() == EPCGAttributePropertySelection::Attribute)
+
+	// A direct copy recreates the target attribute, so a left join into an existing one goes through accessors, which leave unmatched points as they were
+	const bool bKeepUnmatchedValues = bIsPointData
+		&& Settings->MatchMode != EPCGCopyAttributeMatchMode::Index
+		&& Settings->JoinMode == EPCGCopyAttributeJoinMode::Left
+		&& OutputData->Metadata->HasAttribute(TargetAttributeName);
+
+	if (!bAggregate && !bSample && !bKeepUnmatchedValues && !bInputHasAnyExtra && !bOutputHasAnyExtra && SourceAttributeProperty.GetSelection() == EPCGAttributePropertySelection::Attribute && TargetAttributeProperty.GetSelection() == EPCGAttributePropertySelection::Attribute)
 	{
 		if (SourceSpatialData == TargetSpatialData
 			&& SourceAttributeName == TargetAttributeName)
 		{
 			// Nothing to do if we try to copy an attribute into itself
-			AppendOutputData();
 			return true;
 		}
 
-		const FPCGMetadataAttributeBase* SourceAttribute = SourceSpatialData->Metadata->GetConstAttribute(SourceAttributeName);
-		check(SourceAttribute);
-
-		if (bIsPointData)
+		// Within the same data, the attribute is only renamed or aliased in the output, which still reads the target's values
+		if (Settings->bMoveInPlace && Settings->MatchMode == EPCGCopyAttributeMatchMode::Index && SourceSpatialData == TargetSpatialData)
 		{
-			UPCGPointData* OutPointData = CastChecked<UPCGPointData>(OutputData);
-
-			const TArray<FPCGPoint>& SourcePoints = SourcePointData->GetPoints();
-			TArray<FPCGPoint>& TargetPoints = OutPointData->GetMutablePoints();
+			UPCGMetadata* OutputMetadata = OutputData->Metadata;
 
-			// Making sure the target attribute doesn't exist in the target
-			if (OutPointData->Metadata->HasAttribute(TargetAttributeName))
+			const FPCGMetadataAttributeBase* MovedAttribute = OutputMetadata->GetConstAttribute(SourceAttributeName);
+			if (!MovedAttribute)
 			{
-				OutPointData->Metadata->DeleteAttribute(TargetAttributeName);
+				PCGE_LOG(Error, GraphAndLog, FText::Format(LOCTEXT("AttributeAlreadyMoved", "Attribute '{0}' was already moved by another mapping"), FText::FromName(SourceAttributeName)));
+				return false;
 			}
 
-			FPCGMetadataAttributeBase* TargetAttribute = OutPointData->Metadata->CopyAttribute(SourceAttribute, TargetAttributeName, /*bKeepParent=*/ false, /*bCopyEntries=*/ false, /*bCopyValues=*/ true);
-			if (!TargetAttribute)
+			if (OutputMetadata->HasAttribute(TargetAttributeName))
 			{
-				PCGE_LOG(Error, GraphAndLog, FText::Format(LOCTEXT("ErrorCreatingTargetAttribute", "Error while creating target attribute '{0}'"), FText::FromName(TargetAttributeName)));
-				return true;
+				OutputMetadata->DeleteAttribute(TargetAttributeName);
 			}
 
-			if (Settings->bMatchByAttribute)
-			{
-				auto IsIndexAttributeSelector = [](const FPCGAttributePropertySelector& InSelector)
-				{
-					return InSelector.GetSelection() == EPCGAttributePropertySelection::ExtraProperty
-						&& InSelector.GetExtraProperty() == EPCGExtraProperties::Index;
-				};
-				
-				// Target Points
-				TArray<TPair<int32, int32>> TargetMatchValueIndexPairs;
-				{
-					const int32 NumPoints = SourcePoints.Num();
-
-					auto TargetPointAccessor = PCGAttributeAccessorHelpers::CreateConstAccessor(TargetPointData, Settings->TargetMatchAttributeProperty);
-					auto TargetPointKeys = PCGAttributeAccessorHelpers::CreateConstKeys(TargetPointData, Settings->TargetMatchAttributeProperty);
-
-					TArray<int32> TargetMatchValues;
-					TargetMatchValues.SetNum(NumPoints);
-
-					TArrayView<int32> TargetView = TargetMatchValues;
-					if (!TargetPointAccessor->GetRange(TargetView, 0, *TargetPointKeys))
-					{
-						// @todo: ???
-					}
-					else
-					{
-						TargetMatchValueIndexPairs.SetNum(NumPoints);
-						for (int32 PointIdx = 0; PointIdx < NumPoints; ++PointIdx)
-						{
-							TargetMatchValueIndexPairs[PointIdx] = { TargetMatchValues[PointIdx], PointIdx };
-						}
-
-						Algo::SortBy(TargetMatchValueIndexPairs, [](const TPair<int32, int32>& InMatchValueIndexPair)
-						{
-							return InMatchValueIndexPair.Key;
-						});
-					}
-				}
-
-				// Source Points
-				TArray<TPair<int32, int32>> SourceMatchValueIndexPairs;
-				{
-					const int32 NumPoints = SourcePoints.Num();
-
-					auto SourcePointAccessor = PCGAttributeAccessorHelpers::CreateConstAccessor(SourcePointData, Settings->SourceMatchAttributeProperty);
-					auto SourcePointKeys = PCGAttributeAccessorHelpers::CreateConstKeys(SourcePointData, Settings->SourceMatchAttributeProperty);
-
-					TArray<int32> SourceMatchValues;
-					SourceMatchValues.SetNum(NumPoints);
-
-					TArrayView<int32> SourceView = SourceMatchValues;
-					if (!SourcePointAccessor->GetRange(SourceView, 0, *SourcePointKeys))
-					{
-						// @todo: ???
-					}
-					else
-					{
-						SourceMatchValueIndexPairs.SetNum(NumPoints);
-						for (int32 PointIdx = 0; PointIdx < NumPoints; ++PointIdx)
-						{
-							SourceMatchValueIndexPairs[PointIdx] = { SourceMatchValues[PointIdx], PointIdx };
-						}
-
-						Algo::SortBy(SourceMatchValueIndexPairs, [](const TPair<int32, int32>& InMatchValueIndexPair)
-						{
-							return InMatchValueIndexPair.Key;
-						});
-					}
-				}
-
-				// Source to Target Map
-				TArray<int32> SourceToTargetMatchIndirection;
-				// TArray<TPair<int32, int32>> SourceToTargetMatchIndices;
-				{
-					const int32 NumPoints = SourcePoints.Num();
-					SourceToTargetMatchIndirection.Reserve(NumPoints);
-
-					int32 SourcePairIdx = 0, TargetPairIdx = 0, TargetPairLastMatchIdx = 0;					
-					while (SourcePairIdx < NumPoints)
-					{
-						while (TargetPairIdx < NumPoints)
-						{
-							// Check for value match
-							if (TargetMatchValueIndexPairs[TargetPairIdx].Key == SourceMatchValueIndexPairs[SourcePairIdx].Key)
-							{
-								SourceToTargetMatchIndirection.Emplace(TargetMatchValueIndexPairs[TargetPairIdx].Value);
-								// SortedToTargetMatchIndirection.Emplace(SourceMatchValueIndexPairs[SourcePairIdx].Value, TargetMatchValueIndexPairs[TargetPairIdx].Value);
-								TargetPairLastMatchIdx = TargetPairIdx;
-								++SourcePairIdx;
-								++TargetPairIdx;
-								break;
-							}
-							
-							++TargetPairIdx;
-						}
-
-						// Reset, start at last matching target
-						TargetPairIdx = TargetPairLastMatchIdx;
-
-						// No match found, go to next
-						++SourcePairIdx;
-					}
-				}
-
-				// Get TargetAttribute values sorted by matches
-				TArray<int32> TargetValues;
-				{
-					const int32 NumPoints = SourcePoints.Num();
-					
-					TargetValues.SetNum(NumPoints);
-
-					auto SourcePointAccessor = PCGAttributeAccessorHelpers::CreateConstAccessor(SourcePointData, Settings->SourceMatchAttributeProperty);
-					auto SourcePointKeys = PCGAttributeAccessorHelpers::CreateConstKeys(SourcePointData, Settings->SourceMatchAttributeProperty);
+			// An alias can only keep a parent from the parent metadata, which is the target's: the output was duplicated from it
+			const FPCGMetadataAttributeBase* ParentAttribute = TargetSpatialData->Metadata->GetConstAttribute(SourceAttributeName);
 
-					TArrayView<int32> TargetValuesView = TargetValues;
-					if (!SourcePointAccessor->GetRange(TargetValuesView, 0, *SourcePointKeys))
-					{
-					}
+			const bool bMoved = Settings->bDeleteMovedAttribute
+				? OutputMetadata->RenameAttribute(SourceAttributeName, TargetAttributeName)
+				: ParentAttribute && OutputMetadata->CopyAttribute(ParentAttribute, TargetAttributeName, /*bKeepParent=*/ true, /*bCopyEntries=*/ false, /*bCopyValues=*/ false) != nullptr;
 
-					TArrayView<int32> IndirectionView = SourceToTargetMatchIndirection;
+			if (!bMoved)
+			{
+				PCGE_LOG(Error, GraphAndLog, FText::Format(LOCTEXT("FailedToMoveAttribute", "Failed to move attribute '{0}' to '{1}'"), FText::FromName(SourceAttributeName), FText::FromName(TargetAttributeName)));
+				return false;
+			}
 
-					// ArgSort
-					{
-						for (int32 Idx = 0; Idx < IndirectionView.Num(); Idx++)
-						{
-							IndirectionView[Idx] = Idx;
-						}
+			++Target.NumMoved;
+			INC_DWORD_STAT(STAT_PCGPlus_MovedAttributes);
+			return true;
+		}
 
-						TArrayView<int32>(IndirectionView.GetData(), IndirectionView.Num()).Sort([&TargetValuesView](const int32& Lhs, const int32& Rhs)
-						{
-							return TargetValuesView[Lhs] < TargetValuesView[Rhs];
-						});
-					}
-				}
+		const FPCGMetadataAttributeBase* SourceAttribute = SourceSpatialData->Metadata->GetConstAttribute(SourceAttributeName);
+		check(SourceAttribute);
 
-				//
-				{
-					auto OutputPointAccessor = PCGAttributeAccessorHelpers::CreateAccessor(OutputData, Settings->TargetAttributeProperty);
-					auto OutputPointKeys = PCGAttributeAccessorHelpers::CreateKeys(OutputData, Settings->TargetAttributeProperty);
+		if (bIsPointData)
+		{
+			// Making sure the target attribute doesn't exist in the target
+			if (OutputData->Metadata->HasAttribute(TargetAttributeName))
+			{
+				OutputData->Metadata->DeleteAttribute(TargetAttributeName);
+			}
 
-					TArrayView<const int32> TargetValuesView = TargetValues;
-					OutputPointAccessor->SetRange(TargetValuesView, 0, *OutputPointKeys);
-					// OutputPointAccessor->SetRange()				
-				}
+			// When deduplicating, the values are added as they are first used instead
+			FPCGMetadataAttributeBase* TargetAttribute = OutputData->Metadata->CopyAttribute(SourceAttribute, TargetAttributeName, /*bKeepParent=*/ false, /*bCopyEntries=*/ false, /*bCopyValues=*/ !Settings->bDeduplicateValues);
+			if (!TargetAttribute)
+			{
+				PCGE_LOG(Error, GraphAndLog, FText::Format(LOCTEXT("ErrorCreatingTargetAttribute", "Error while creating target attribute '{0}'"), FText::FromName(TargetAttributeName)));
+				return false;
 			}
 
-			// For Point -> Point, the entry keys may not match the source points, so we explicitly write for all the target points
-			for (int32 PointIdx = 0; PointIdx < SourcePoints.Num(); ++PointIdx)
+			FPCGCopyAttributeOperation& Operation = Target.Operations.Emplace_GetRef();
+			Operation.SourceAttribute = SourceAttribute;
+			Operation.TargetAttribute = TargetAttribute;
+			INC_DWORD_STAT(STAT_PCGPlus_DirectCopies);
+
+			if (Settings->bDeduplicateValues)
 			{
-				PCGMetadataEntryKey& TargetKey = TargetPoints[PointIdx].MetadataEntry;
-				OutPointData->Metadata->InitializeOnSet(TargetKey);
-				check(TargetKey != PCGInvalidEntryKey);
-				TargetAttribute->SetValueFromValueKey(TargetKey, SourceAttribute->GetValueKey(SourcePoints[PointIdx].MetadataEntry));
+				Operation.ValueKeyRemap.Init(UE::PCGPlus::Private::UnmappedValueKey, SourceAttribute->GetValueKeyOffsetForChild());
 			}
 		}
 		else
@@ -418,18 +1319,19 @@ bool FPCGCopyAttributeElement::ExecuteInternal(FPCGContext* Context) const
 			}
 		}
 
-		AppendOutputData();
-
 		return true;
 	}
 
-	TUniquePtr<const IPCGAttributeAccessor> InputAccessor = PCGAttributeAccessorHelpers::CreateConstAccessor(SourceSpatialData, SourceAttributeProperty);
-	TUniquePtr<const IPCGAttributeAccessorKeys> InputKeys = PCGAttributeAccessorHelpers::CreateConstKeys(SourceSpatialData, SourceAttributeProperty);
+	// Samples are read as points, with their attributes in the sample metadata, which inherits the attributes of the source
+	TUniquePtr<const IPCGAttributeAccessor> InputAccessor = PCGAttributeAccessorHelpers::CreateConstAccessor(bSample ? Context->SampleData.Get() : SourceSpatialData, SourceAttributeProperty);
+	TUniquePtr<const IPCGAttributeAccessorKeys> InputKeys = bSample
+		? MakeUnique<const FPCGAttributeAccessorKeysPoints>(TArrayView<const FPCGPoint>(Target.SampledPoints))
+		: PCGAttributeAccessorHelpers::CreateConstKeys(SourceSpatialData, SourceAttributeProperty);
 
 	if (!InputAccessor.IsValid() || !InputKeys.IsValid())
 	{
 		PCGE_LOG(Error, GraphAndLog, LOCTEXT("FailedToCreateInputAccessor", "Failed to create input accessor or iterator"));
-		return true;
+		return false;
 	}
 
 	// If the target is an attribute, only create a new one if the attribute doesn't already exist or we have any extra.
@@ -441,11 +1343,16 @@ bool FPCGCopyAttributeElement::ExecuteInternal(FPCGContext* Context) const
 			using AttributeType = decltype(Dummy);
 			return PCGMetadataElementCommon::ClearOrCreateAttribute(OutputData->Metadata, TargetAttributeName, AttributeType{}) != nullptr;
 		};
+
+		// Counts are integers, whatever the type of the source values
+		const bool bCreated = (bAggregate && Settings->Aggregation == EPCGCopyAttributeAggregation::Count)
+			? CreateAttribute(int32{})
+			: PCGMetadataAttribute::CallbackWithRightType(InputAccessor->GetUnderlyingType(), CreateAttribute);
 		
-		if (!PCGMetadataAttribute::CallbackWithRightType(InputAccessor->GetUnderlyingType(), CreateAttribute))
+		if (!bCreated)
 		{
 			PCGE_LOG(Error, GraphAndLog, FText::Format(LOCTEXT("FailedToCreateNewAttribute", "Failed to create new attribute '{0}'"), FText::FromName(TargetAttributeName)));
-			return true;
+			return false;
 		}
 	}
 
@@ -455,57 +1362,368 @@ bool FPCGCopyAttributeElement::ExecuteInternal(FPCGContext* Context) const
 	if (!OutputAccessor.IsValid() || !OutputKeys.IsValid())
 	{
 		PCGE_LOG(Error, GraphAndLog, LOCTEXT("FailedToCreateOutputAccessor", "Failed to create output accessor or iterator"));
-		return true;
+		return false;
 	}
 
 	if (OutputAccessor->IsReadOnly())
 	{
 		PCGE_LOG(Error, GraphAndLog, FText::Format(LOCTEXT("OutputAccessorIsReadOnly", "Attribute/Property '{0}' is read only."), TargetAttributeProperty.GetDisplayText()));
-		return true;
+		return false;
+	}
+
+	FPCGCopyAttributeOperation& Operation = Target.Operations.Emplace_GetRef();
+	INC_DWORD_STAT(STAT_PCGPlus_AccessorCopies);
+	Operation.InputAccessor = MoveTemp(InputAccessor);
+	Operation.InputKeys = MoveTemp(InputKeys);
+	Operation.OutputAccessor = MoveTemp(OutputAccessor);
+	Operation.OutputKeys = MoveTemp(OutputKeys);
+
+	// Writing to an attribute allocates entry keys and appends values, which must stay serial to be deterministic, but the values can still be read concurrently.
+	// Properties write to their own point only, so those can be processed concurrently.
+	Operation.bCanReadConcurrently = bIsPointData || bSample;
+	Operation.bCanWriteConcurrently = Operation.bCanReadConcurrently && TargetAttributeProperty.GetSelection() != EPCGAttributePropertySelection::Attribute;
+
+	return true;
+}
+
+bool FPCGCopyAttributeElement::MatchPoints(FPCGCopyAttributeContext* Context, FPCGCopyAttributeTarget& Target) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FPCGCopyAttributeElement::MatchPoints);
+	check(Target.MatchTask.IsValid());
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_PCGPlus_CopyAttribute_Match);
+
+		if (!Target.MatchTask->Step(UE::PCGPlus::Private::ElementsPerTimeSlice))
+		{
+			return false;
+		}
+	}
+
+	const UPCGCopyAttributeSettings* Settings = Context->GetInputSettings<UPCGCopyAttributeSettings>();
+	check(Settings);
+
+	UE::PCGPlus::FJoinResult MatchResult = Target.MatchTask->TakeResult();
+	Target.MatchTask.Reset();
+
+	// Keys that only share their fingerprint are told apart here
+	{
+		SCOPE_CYCLE_COUNTER(STAT_PCGPlus_CopyAttribute_Verify);
+		UE::PCGPlus::VerifyMatches(Context->SourceMatchKeys, Target.MatchKeys, MatchResult, Context->DuplicatePolicy);
+		Target.MatchKeys.Reset();
+	}
+
+	INC_DWORD_STAT(STAT_PCGPlus_JoinedTargets);
+	INC_DWORD_STAT_BY(STAT_PCGPlus_PointsMatched, MatchResult.NumMatched);
+	INC_DWORD_STAT_BY(STAT_PCGPlus_PointsUnmatched, MatchResult.NumUnmatched);
+
+	Target.MatchResult = MakeShared<UE::PCGPlus::FJoinResult>(MoveTemp(MatchResult));
+
+	if (Settings->bCacheMatch && !Target.bSample)
+	{
+		UE::PCGPlus::FJoinCache::Get().Add(Target.MatchCacheKey, Target.MatchResult);
+	}
+
+	Target.VerboseMessages.Add(FText::Format(LOCTEXT("MatchCounts", "Matched {0} target points, {1} target points have no match in the source"), Target.MatchResult->NumMatched, Target.MatchResult->NumUnmatched));
+
+	Target.Stage = EPCGCopyAttributeStage::Copy;
+	return true;
+}
+
+bool FPCGCopyAttributeElement::CopyValueKeys(FPCGCopyAttributeContext* Context, FPCGCopyAttributeTarget& Target, FPCGCopyAttributeOperation& Operation) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_PCGPlus_CopyAttribute_CopyValueKeys);
+	TRACE_CPUPROFILER_EVENT_SCOPE(FPCGCopyAttributeElement::CopyValueKeys);
+
+	const UPCGCopyAttributeSettings* Settings = Context->GetInputSettings<UPCGCopyAttributeSettings>();
+	check(Settings);
+
+	UPCGPointData* OutPointData = CastChecked<UPCGPointData>(Target.OutputSpatialData);
+	const bool bInheritEntries = Settings->OutputMode == EPCGCopyAttributeOutputMode::InheritEntries;
+	const int32 BatchSize = FMath::Max(Settings->BatchSize, 1);
+
+	const TArray<FPCGPoint>& SourcePoints = Context->SourcePointData->GetPoints();
+	TArray<FPCGPoint>& TargetPoints = OutPointData->GetMutablePoints();
+
+	// For each target point, the source point to copy from. Without matching, points are paired by index.
+	const TArray<int32>* TargetToSource = Target.MatchResult.IsValid() ? &Target.MatchResult->TargetToSource : nullptr;
+
+	// Entries are created once for the whole output, before the first direct copy
+	if (!Target.bEntriesInitialized)
+	{
+		UE::PCGPlus::Private::InitializeEntries(OutPointData, TargetToSource, bInheritEntries, BatchSize);
+		Target.bEntriesInitialized = true;
+	}
+
+	// Each slice is gathered in parallel batches, then written with one bulk call
+	TArray<int32> WrittenPoints;
+	TArray<PCGMetadataEntryKey> SourceEntryKeys;
+	TArray<PCGMetadataEntryKey> TargetEntryKeys;
+	TArray<PCGMetadataValueKey> ValueKeys;
+
+	// For Point -> Point, the entry keys may not match the source points, so we explicitly write for all the target points
+	if (Target.CurrentIndex < TargetPoints.Num())
+	{
+		const int32 EndIndex = FMath::Min(Target.CurrentIndex + UE::PCGPlus::Private::ElementsPerTimeSlice, TargetPoints.Num());
+
+		UE::PCGPlus::Private::ParallelFilterIndices(Target.CurrentIndex, EndIndex, BatchSize, WrittenPoints, [TargetToSource](int32 PointIdx)
+		{
+			return !TargetToSource || (*TargetToSource)[PointIdx] != INDEX_NONE;
+		});
+
+		SourceEntryKeys.SetNumUninitialized(WrittenPoints.Num());
+		TargetEntryKeys.SetNumUninitialized(WrittenPoints.Num());
+
+		ParallelFor(FMath::DivideAndRoundUp(WrittenPoints.Num(), BatchSize), [&SourcePoints, &TargetPoints, &WrittenPoints, &SourceEntryKeys, &TargetEntryKeys, TargetToSource, BatchSize](int32 BatchIdx)
+		{
+			const int32 Start = BatchIdx * BatchSize;
+			const int32 End = FMath::Min(Start + BatchSize, WrittenPoints.Num());
+			for (int32 Idx = Start; Idx < End; ++Idx)
+			{
+				const int32 PointIdx = WrittenPoints[Idx];
+				const int32 SourcePointIdx = TargetToSource ? (*TargetToSource)[PointIdx] : PointIdx;
+
+				SourceEntryKeys[Idx] = SourcePoints[SourcePointIdx].MetadataEntry;
+				TargetEntryKeys[Idx] = TargetPoints[PointIdx].MetadataEntry;
+				check(TargetEntryKeys[Idx] != PCGInvalidEntryKey);
+			}
+		});
+
+		ValueKeys.SetNumUninitialized(SourceEntryKeys.Num());
+		Operation.SourceAttribute->GetValueKeys(SourceEntryKeys, ValueKeys);
+
+		if (!Operation.ValueKeyRemap.IsEmpty())
+		{
+			UE::PCGPlus::Private::RemapValueKeys(Operation, ValueKeys);
+		}
+
+		Operation.TargetAttribute->SetValuesFromValueKeys(TargetEntryKeys, ValueKeys);
+		UE::PCGPlus::Private::CountCopied(Target, ValueKeys.Num(), sizeof(PCGMetadataValueKey));
+
+		Target.CurrentIndex = EndIndex;
 	}
 
-	// At this point, we are ready.
-	auto Operation = [&InputAccessor, &InputKeys, &OutputAccessor, &OutputKeys, Context](auto _)
+	return Target.CurrentIndex == TargetPoints.Num();
+}
+
+bool FPCGCopyAttributeElement::CopyValues(FPCGCopyAttributeContext* Context, FPCGCopyAttributeTarget& Target, FPCGCopyAttributeOperation& Operation) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_PCGPlus_CopyAttribute_CopyValues);
+	TRACE_CPUPROFILER_EVENT_SCOPE(FPCGCopyAttributeElement::CopyValues);
+
+	const UPCGCopyAttributeSettings* Settings = Context->GetInputSettings<UPCGCopyAttributeSettings>();
+	check(Settings);
+
+	const IPCGAttributeAccessor& InputAccessor = *Operation.InputAccessor;
+	const IPCGAttributeAccessorKeys& InputKeys = *Operation.InputKeys;
+	IPCGAttributeAccessor& OutputAccessor = *Operation.OutputAccessor;
+	IPCGAttributeAccessorKeys& OutputKeys = *Operation.OutputKeys;
+
+	const bool bCanReadConcurrently = Operation.bCanReadConcurrently;
+	const bool bCanWriteConcurrently = Operation.bCanWriteConcurrently;
+	const int32 BatchSize = FMath::Max(Settings->BatchSize, 1);
+	const int32 NumberOfElements = OutputKeys.GetNum();
+
+	// With a match, each target element reads the value of its matched source element, gathered from a column read up front.
+	const TArray<int32>* TargetToSource = Target.MatchResult.IsValid() ? &Target.MatchResult->TargetToSource : nullptr;
+
+	// A slice is a round of batches over all workers when parallel, otherwise a fixed number of elements.
+	const int32 SliceSize = bCanReadConcurrently
+		? BatchSize * FMath::Max(1, FTaskGraphInterface::Get().GetNumWorkerThreads())
+		: UE::PCGPlus::Private::ElementsPerTimeSlice;
+
+	int32 SliceStart = 0;
+	int32 SliceEnd = 0;
+
+	// When aggregating, the source column is reduced per group before being gathered
+	const bool bAggregate = UE::PCGPlus::Private::IsAggregating(Context, Settings);
+	const UE::PCGPlus::EAggregation Aggregation = UE::PCGPlus::Private::GetAggregation(Settings->Aggregation);
+
+	// Numeric conversions are done in bulk on each chunk rather than value by value in the accessor.
+	const bool bConvertInBulk = UE::PCGPlus::CanReadConvertedRange(InputAccessor.GetUnderlyingType(), OutputAccessor.GetUnderlyingType());
+
+	auto CopySlice = [&InputAccessor, &InputKeys, &OutputAccessor, &OutputKeys, &Operation, &Target, &SliceStart, &SliceEnd, TargetToSource, bCanReadConcurrently, bCanWriteConcurrently, BatchSize, bAggregate, Aggregation, bConvertInBulk, Context](auto _)
 	{
 		using OutputType = decltype(_);
-		OutputType Value{};
+		using FSourceColumn = UE::PCGPlus::Private::TSourceColumn<OutputType>;
 
-		EPCGAttributeAccessorFlags Flags = EPCGAttributeAccessorFlags::AllowBroadcast | EPCGAttributeAccessorFlags::AllowConstructible;
+		const EPCGAttributeAccessorFlags Flags = EPCGAttributeAccessorFlags::AllowBroadcast | EPCGAttributeAccessorFlags::AllowConstructible;
 
-		const int32 NumberOfElements = OutputKeys->GetNum();
-		constexpr int32 ChunkSize = 256;
+		auto ReadInput = [&InputAccessor, &InputKeys, Flags, bConvertInBulk](TArrayView<OutputType> OutValues, int32 InIndex) -> bool
+		{
+			if constexpr (UE::PCGPlus::TIsBulkConvertible_V<OutputType>)
+			{
+				if (bConvertInBulk)
+				{
+					return UE::PCGPlus::ReadConvertedRange<OutputType>(InputAccessor, InputKeys, InIndex, OutValues);
+				}
+			}
+
+			return InputAccessor.GetRange<OutputType>(OutValues, InIndex, InputKeys, Flags);
+		};
+
+		const TArray<OutputType>* SourceValues = nullptr;
+		if (TargetToSource)
+		{
+			if (!Operation.SourceColumn.IsValid())
+			{
+				TUniquePtr<FSourceColumn> SourceColumn = MakeUnique<FSourceColumn>(InputKeys.GetNum());
+
+				// Counts do not depend on the source values
+				const bool bReadValues = !bAggregate || Aggregation != UE::PCGPlus::EAggregation::Count;
+				if (bReadValues && !ReadInput(SourceColumn->Values, 0))
+				{
+					Target.Errors.Add(LOCTEXT("ConversionFailed", "Source attribute/property cannot be converted to target attribute/property"));
+					return false;
+				}
+
+				if (bAggregate)
+				{
+					if constexpr (UE::PCGPlus::TIsAggregatable_V<OutputType>)
+					{
+						UE::PCGPlus::AggregateGroupsInPlace<OutputType>(SourceColumn->Values, Context->SourceGroups, Aggregation);
+					}
+					else
+					{
+						Target.Errors.Add(LOCTEXT("UnsupportedAggregationType", "Only numeric and vector values can be aggregated"));
+						return false;
+					}
+				}
+
+				Operation.SourceColumn = MoveTemp(SourceColumn);
+			}
+
+			SourceValues = &static_cast<const FSourceColumn*>(Operation.SourceColumn.Get())->Values;
+		}
 
-		TArray<OutputType, TInlineAllocator<ChunkSize>> TempValues;
-		TempValues.SetNum(ChunkSize);
+		const int32 NumberOfBatches = (SliceEnd - SliceStart + BatchSize - 1) / BatchSize;
+		constexpr int32 ChunkSize = 256;
 
-		const int32 NumberOfIterations = (NumberOfElements + ChunkSize - 1) / ChunkSize;
+		std::atomic<bool> bSuccess = true;
 
-		for (int32 i = 0; i < NumberOfIterations; ++i)
+		// Reads the values of a range of elements, from their matched source element or else their current value
+		auto GatherRange = [&OutputAccessor, &OutputKeys, &ReadInput, SourceValues, TargetToSource, Flags](TArrayView<OutputType> OutValues, int32 InIndex) -> bool
 		{
-			const int32 StartIndex = i * ChunkSize;
-			const int32 Range = FMath::Min(NumberOfElements - StartIndex, ChunkSize);
-			TArrayView<OutputType> View(TempValues.GetData(), Range);
+			if (!SourceValues)
+			{
+				return ReadInput(OutValues, InIndex);
+			}
 
-			if (!InputAccessor->GetRange<OutputType>(View, StartIndex, *InputKeys, Flags)
-				|| !OutputAccessor->SetRange<OutputType>(View, StartIndex, *OutputKeys, Flags))
+			if (!OutputAccessor.GetRange<OutputType>(OutValues, InIndex, OutputKeys, Flags))
 			{
-				PCGE_LOG_C(Error, GraphAndLog, Context, LOCTEXT("ConversionFailed", "Source attribute/property cannot be converted to target attribute/property"));
 				return false;
 			}
+
+			for (int32 Idx = 0; Idx < OutValues.Num(); ++Idx)
+			{
+				const int32 SourceIdx = (*TargetToSource)[InIndex + Idx];
+				if (SourceIdx != INDEX_NONE)
+				{
+					OutValues[Idx] = (*SourceValues)[SourceIdx];
+				}
+			}
+
+			return true;
+		};
+
+		if (bCanWriteConcurrently)
+		{
+			// Each batch walks its elements in chunks, through its own temporary values.
+			auto ProcessBatch = [&OutputAccessor, &OutputKeys, &GatherRange, &bSuccess, Flags, SliceStart, SliceEnd, BatchSize](int32 BatchIndex)
+			{
+				TArray<OutputType, TInlineAllocator<ChunkSize>> TempValues;
+				TempValues.SetNum(ChunkSize);
+
+				const int32 BatchStart = SliceStart + BatchIndex * BatchSize;
+				const int32 BatchEnd = FMath::Min(SliceEnd, BatchStart + BatchSize);
+
+				for (int32 StartIndex = BatchStart; StartIndex < BatchEnd && bSuccess; StartIndex += ChunkSize)
+				{
+					TArrayView<OutputType> View(TempValues.GetData(), FMath::Min(BatchEnd - StartIndex, ChunkSize));
+
+					if (!GatherRange(View, StartIndex) || !OutputAccessor.SetRange<OutputType>(View, StartIndex, OutputKeys, Flags))
+					{
+						bSuccess = false;
+					}
+				}
+			};
+
+			ParallelFor(NumberOfBatches, ProcessBatch, /*bForceSingleThread=*/ NumberOfBatches <= 1);
+		}
+		else
+		{
+			// The whole slice is gathered in parallel batches, then written with one serial call, which creates the entries and appends the values in order
+			TArray<OutputType> SliceValues;
+			SliceValues.SetNum(SliceEnd - SliceStart);
+
+			ParallelFor(NumberOfBatches, [&GatherRange, &SliceValues, &bSuccess, SliceStart, SliceEnd, BatchSize](int32 BatchIndex)
+			{
+				const int32 BatchStart = SliceStart + BatchIndex * BatchSize;
+				const int32 BatchEnd = FMath::Min(SliceEnd, BatchStart + BatchSize);
+
+				if (!GatherRange(TArrayView<OutputType>(SliceValues).Slice(BatchStart - SliceStart, BatchEnd - BatchStart), BatchStart))
+				{
+					bSuccess = false;
+				}
+			}, /*bForceSingleThread=*/ !bCanReadConcurrently || NumberOfBatches <= 1);
+
+			if (bSuccess && !OutputAccessor.SetRange<OutputType>(SliceValues, SliceStart, OutputKeys, Flags))
+			{
+				bSuccess = false;
+			}
+		}
+
+		if (!bSuccess)
+		{
+			Target.Errors.Add(LOCTEXT("ConversionFailed", "Source attribute/property cannot be converted to target attribute/property"));
+			return false;
 		}
 
 		return true;
 	};
 
-	if (!PCGMetadataAttribute::CallbackWithRightType(OutputAccessor->GetUnderlyingType(), Operation))
+	const int32 ValueSize = PCGMetadataAttribute::CallbackWithRightType(OutputAccessor.GetUnderlyingType(), [](auto Dummy) -> int32 { return sizeof(Dummy); });
+
+	if (Target.CurrentIndex < NumberOfElements)
 	{
-		PCGE_LOG(Error, GraphAndLog, LOCTEXT("ErrorGettingSettingValues", "Error while getting/setting values"));
-		return true;
+		SliceStart = Target.CurrentIndex;
+		SliceEnd = FMath::Min(SliceStart + SliceSize, NumberOfElements);
+
+		if (!PCGMetadataAttribute::CallbackWithRightType(OutputAccessor.GetUnderlyingType(), CopySlice))
+		{
+			UE::PCGPlus::Private::FailTarget(Target, LOCTEXT("ErrorGettingSettingValues", "Error while getting/setting values"));
+			return true;
+		}
+
+		Target.CurrentIndex = SliceEnd;
+		UE::PCGPlus::Private::CountCopied(Target, SliceEnd - SliceStart, ValueSize);
 	}
 
-	AppendOutputData();
+	return Target.CurrentIndex == NumberOfElements;
+}
 
-	return true;
+void FPCGCopyAttributeElement::RemoveUnmatchedPoints(FPCGCopyAttributeTarget& Target) const
+{
+	UPCGPointData* OutPointData = CastChecked<UPCGPointData>(Target.OutputSpatialData);
+	TArray<FPCGPoint>& Points = OutPointData->GetMutablePoints();
+	const TArray<int32>& TargetToSource = Target.MatchResult->TargetToSource;
+
+	// Matched points are compacted in place, keeping their order
+	int32 NumKept = 0;
+	for (int32 PointIdx = 0; PointIdx < Points.Num(); ++PointIdx)
+	{
+		if (TargetToSource[PointIdx] != INDEX_NONE)
+		{
+			if (NumKept != PointIdx)
+			{
+				Points[NumKept] = MoveTemp(Points[PointIdx]);
+			}
+
+			++NumKept;
+		}
+	}
+
+	Points.SetNum(NumKept);
 }
 
 #undef LOCTEXT_NAMESPACE
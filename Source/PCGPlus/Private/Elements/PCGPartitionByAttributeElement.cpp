@@ -0,0 +1,233 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Elements/PCGPartitionByAttributeElement.h"
+
+#include "Async/ParallelFor.h"
+#include "Data/PCGPointData.h"
+#include "Helpers/PCGMatchKeys.h"
+#include "Helpers/PCGScratch.h"
+#include "PCGContext.h"
+#include "PCGModule.h"
+#include "PCGPin.h"
+#include "PCGPlusStats.h"
+
+#define LOCTEXT_NAMESPACE "PCGPartitionByAttributeElement"
+
+DECLARE_CYCLE_STAT(TEXT("Partition By Attribute"), STAT_PCGPlus_PartitionByAttribute, STATGROUP_PCGPlus);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Partitions Created"), STAT_PCGPlus_PartitionsCreated, STATGROUP_PCGPlus);
+
+namespace UE::PCGPlus::PartitionByAttribute
+{
+	static FName NodeName = TEXT("PartitionByAttribute");
+	static FText NodeTitle = LOCTEXT("NodeTitle", "Partition By Attribute");
+
+	/** Most counters kept over all the tasks of a partition. With many partitions, fewer tasks are used instead. */
+	static constexpr int64 MaxCounters = 4 * 1024 * 1024;
+
+	/**
+	 * Turns the first point of each group, as found by GroupKeys, into consecutive partition indices in order of first appearance.
+	 * The first point of a group always comes before the others, so this is done in place in a single pass. Returns the first point of each partition.
+	 */
+	TArray<int32> NumberPartitions(TArray<int32>& InOutGroups)
+	{
+		TArray<int32> FirstPoints;
+		for (int32 PointIdx = 0; PointIdx < InOutGroups.Num(); ++PointIdx)
+		{
+			const int32 FirstIdx = InOutGroups[PointIdx];
+			if (FirstIdx == PointIdx)
+			{
+				InOutGroups[PointIdx] = FirstPoints.Add(PointIdx);
+			}
+			else
+			{
+				check(FirstIdx < PointIdx);
+				InOutGroups[PointIdx] = InOutGroups[FirstIdx];
+			}
+		}
+
+		return FirstPoints;
+	}
+
+	/**
+	 * Copies each point to the output of its partition, keeping their order.
+	 * Each task counts the points of its range per partition, the counts are prefix summed into where each task writes, and the tasks then scatter their ranges concurrently.
+	 */
+	void PartitionPoints(TArrayView<const FPCGPoint> InPoints, TArrayView<const int32> InPartitions, TArrayView<TArray<FPCGPoint>*> OutPoints, int32 InBatchSize)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(UE::PCGPlus::PartitionByAttribute::PartitionPoints);
+		check(InPoints.Num() == InPartitions.Num());
+
+		const int32 NumPoints = InPoints.Num();
+		const int32 NumPartitions = OutPoints.Num();
+		const int32 NumTasks = static_cast<int32>(FMath::Clamp<int64>(MaxCounters / NumPartitions, 1, FMath::DivideAndRoundUp(NumPoints, FMath::Max(InBatchSize, 1))));
+		const int32 PointsPerTask = FMath::DivideAndRoundUp(NumPoints, NumTasks);
+
+		// Counts of each task, then where each task writes its first point of each partition
+		TArray<int32> Offsets = TScratchPool<int32>::Acquire(NumTasks * NumPartitions);
+		FMemory::Memzero(Offsets.GetData(), Offsets.Num() * sizeof(int32));
+
+		ParallelFor(NumTasks, [&InPartitions, &Offsets, NumPoints, NumPartitions, PointsPerTask](int32 TaskIdx)
+		{
+			int32* Counts = Offsets.GetData() + TaskIdx * NumPartitions;
+			const int32 End = FMath::Min(NumPoints, (TaskIdx + 1) * PointsPerTask);
+			for (int32 PointIdx = TaskIdx * PointsPerTask; PointIdx < End; ++PointIdx)
+			{
+				++Counts[InPartitions[PointIdx]];
+			}
+		});
+
+		for (int32 PartitionIdx = 0; PartitionIdx < NumPartitions; ++PartitionIdx)
+		{
+			int32 Offset = 0;
+			for (int32 TaskIdx = 0; TaskIdx < NumTasks; ++TaskIdx)
+			{
+				int32& Count = Offsets[TaskIdx * NumPartitions + PartitionIdx];
+				const int32 TaskCount = Count;
+				Count = Offset;
+				Offset += TaskCount;
+			}
+
+			OutPoints[PartitionIdx]->SetNumUninitialized(Offset);
+		}
+
+		ParallelFor(NumTasks, [InPoints, &InPartitions, &Offsets, &OutPoints, NumPoints, NumPartitions, PointsPerTask](int32 TaskIdx)
+		{
+			int32* TaskOffsets = Offsets.GetData() + TaskIdx * NumPartitions;
+			const int32 End = FMath::Min(NumPoints, (TaskIdx + 1) * PointsPerTask);
+			for (int32 PointIdx = TaskIdx * PointsPerTask; PointIdx < End; ++PointIdx)
+			{
+				const int32 PartitionIdx = InPartitions[PointIdx];
+				(*OutPoints[PartitionIdx])[TaskOffsets[PartitionIdx]++] = InPoints[PointIdx];
+			}
+		});
+
+		TScratchPool<int32>::Release(MoveTemp(Offsets));
+	}
+}
+
+#if WITH_EDITOR
+FName UPCGPartitionByAttributeSettings::GetDefaultNodeName() const
+{
+	return UE::PCGPlus::PartitionByAttribute::NodeName;
+}
+
+FText UPCGPartitionByAttributeSettings::GetDefaultNodeTitle() const
+{
+	return UE::PCGPlus::PartitionByAttribute::NodeTitle;
+}
+
+FText UPCGPartitionByAttributeSettings::GetNodeTooltipText() const
+{
+	return Super::GetNodeTooltipText();
+}
+#endif
+
+FName UPCGPartitionByAttributeSettings::AdditionalTaskName() const
+{
+	FString TaskName = FString::Printf(TEXT("%s %s"),
+		*UE::PCGPlus::PartitionByAttribute::NodeName.ToString(),
+		*PartitionAttributeProperty.GetName().ToString());
+
+	if (!AdditionalPartitionAttributeProperties.IsEmpty())
+	{
+		TaskName += FString::Printf(TEXT(" (+%d)"), AdditionalPartitionAttributeProperties.Num());
+	}
+
+	return FName(TaskName);
+}
+
+TArray<FPCGPinProperties> UPCGPartitionByAttributeSettings::InputPinProperties() const
+{
+	TArray<FPCGPinProperties> PinProperties;
+	PinProperties.Emplace(PCGPinConstants::DefaultInputLabel, EPCGDataType::Point, /*bInAllowMultipleConnections=*/ true);
+
+	return PinProperties;
+}
+
+TArray<FPCGPinProperties> UPCGPartitionByAttributeSettings::OutputPinProperties() const
+{
+	TArray<FPCGPinProperties> PinProperties;
+	PinProperties.Emplace(PCGPinConstants::DefaultOutputLabel, EPCGDataType::Point);
+
+	return PinProperties;
+}
+
+FPCGElementPtr UPCGPartitionByAttributeSettings::CreateElement() const
+{
+	return MakeShared<FPCGPartitionByAttributeElement>();
+}
+
+bool FPCGPartitionByAttributeElement::ExecuteInternal(FPCGContext* Context) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FPCGPartitionByAttributeElement::Execute);
+	SCOPE_CYCLE_COUNTER(STAT_PCGPlus_PartitionByAttribute);
+
+	const UPCGPartitionByAttributeSettings* Settings = Context->GetInputSettings<UPCGPartitionByAttributeSettings>();
+	check(Settings);
+
+	const TArray<FPCGAttributePropertyInputSelector> Selectors = UE::PCGPlus::GetKeySelectors(Settings->PartitionAttributeProperty, Settings->AdditionalPartitionAttributeProperties);
+	const TArray<FPCGTaggedData> Inputs = Context->InputData.GetInputsByPin(PCGPinConstants::DefaultInputLabel);
+
+	// Inputs failing validation are skipped, the others are still partitioned
+	for (const FPCGTaggedData& Input : Inputs)
+	{
+		const UPCGPointData* PointData = Cast<const UPCGPointData>(Input.Data);
+		if (!PointData)
+		{
+			PCGE_LOG(Error, GraphAndLog, LOCTEXT("InputNotPointData", "Input is not a point data"));
+			continue;
+		}
+
+		const TArray<FPCGPoint>& Points = PointData->GetPoints();
+		if (Points.IsEmpty())
+		{
+			continue;
+		}
+
+		// Same keys as the match of Copy Attribute, so partitions group exactly the points it would match together
+		UE::PCGPlus::FMatchKeys Keys;
+		if (!Keys.Read(Context, PointData, Selectors, /*InTypesFrom=*/ nullptr, /*bInKeepValues=*/ Settings->bTagOutputs))
+		{
+			continue;
+		}
+
+		TArray<int32> Partitions;
+		UE::PCGPlus::GroupKeys(Keys, Partitions);
+		const TArray<int32> FirstPoints = UE::PCGPlus::PartitionByAttribute::NumberPartitions(Partitions);
+
+		if (FirstPoints.Num() > Settings->MaxPartitions)
+		{
+			PCGE_LOG(Error, GraphAndLog, FText::Format(LOCTEXT("TooManyPartitions", "Input has {0} distinct values, more than the maximum of {1} partitions"), FirstPoints.Num(), Settings->MaxPartitions));
+			continue;
+		}
+
+		const FString TagPrefix = Settings->bTagOutputs ? UE::PCGPlus::GetKeySelectorsString(PointData, Selectors) + TEXT("=") : FString();
+
+		TArray<TArray<FPCGPoint>*> OutputPoints;
+		OutputPoints.Reserve(FirstPoints.Num());
+		for (const int32 FirstPointIdx : FirstPoints)
+		{
+			// Points keep their metadata entries, which are looked up through the parent metadata
+			UPCGPointData* OutputData = NewObject<UPCGPointData>();
+			OutputData->InitializeFromData(PointData);
+
+			FPCGTaggedData& Output = Context->OutputData.TaggedData.Add_GetRef(Input);
+			Output.Data = OutputData;
+
+			if (Settings->bTagOutputs)
+			{
+				Output.Tags.Add(TagPrefix + Keys.ToString(FirstPointIdx));
+			}
+
+			OutputPoints.Add(&OutputData->GetMutablePoints());
+		}
+
+		UE::PCGPlus::PartitionByAttribute::PartitionPoints(Points, Partitions, OutputPoints, Settings->BatchSize);
+
+		INC_DWORD_STAT_BY(STAT_PCGPlus_PartitionsCreated, FirstPoints.Num());
+	}
+
+	return true;
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,50 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Helpers/PCGJoinCache.h"
+
+#include "HAL/IConsoleManager.h"
+
+namespace UE::PCGPlus::JoinCache
+{
+	static TAutoConsoleVariable<int32> CVarBudgetMB(
+		TEXT("pcgplus.JoinCache.BudgetMB"),
+		64,
+		TEXT("Memory budget, in MB, of the join results kept for reuse by Copy Attribute. 0 disables the cache."));
+
+	int64 GetBudget()
+	{
+		return static_cast<int64>(FMath::Max(CVarBudgetMB.GetValueOnAnyThread(), 0)) * 1024 * 1024;
+	}
+}
+
+namespace UE::PCGPlus
+{
+	FJoinCache& FJoinCache::Get()
+	{
+		static FJoinCache Instance;
+		return Instance;
+	}
+
+	TSharedPtr<const FJoinResult> FJoinCache::Find(const FJoinCacheKey& InKey)
+	{
+		return Cache.Find(InKey);
+	}
+
+	void FJoinCache::Add(const FJoinCacheKey& InKey, TSharedPtr<const FJoinResult> InResult)
+	{
+		check(InResult.IsValid());
+
+		const int64 Size = sizeof(FJoinResult) + InResult->TargetToSource.GetAllocatedSize();
+		Cache.Add(InKey, MoveTemp(InResult), Size, JoinCache::GetBudget());
+	}
+
+	void FJoinCache::Empty()
+	{
+		Cache.Empty();
+	}
+
+	int64 FJoinCache::GetAllocatedSize() const
+	{
+		return Cache.GetAllocatedSize();
+	}
+}
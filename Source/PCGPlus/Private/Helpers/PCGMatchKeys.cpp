@@ -0,0 +1,347 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Helpers/PCGMatchKeys.h"
+
+#include "Helpers/PCGScratch.h"
+#include "Metadata/Accessors/IPCGAttributeAccessor.h"
+#include "Metadata/Accessors/PCGAttributeAccessorHelpers.h"
+#include "Metadata/Accessors/PCGAttributeAccessorKeys.h"
+#include "Metadata/PCGAttributePropertySelector.h"
+#include "PCGContext.h"
+#include "PCGModule.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "UObject/SoftObjectPath.h"
+
+#define LOCTEXT_NAMESPACE "PCGMatchKeys"
+
+namespace UE::PCGPlus::MatchKeys
+{
+	/** Finalizer of SplitMix64, spreading the bits of a value over the whole 64 bits. */
+	uint64 Mix(uint64 X)
+	{
+		X ^= X >> 30;
+		X *= 0xbf58476d1ce4e5b9ull;
+		X ^= X >> 27;
+		X *= 0x94d049bb133111ebull;
+		X ^= X >> 31;
+		return X;
+	}
+
+	uint64 Combine(uint64 InHash, uint64 InValue)
+	{
+		return Mix(InHash ^ (InValue + 0x9e3779b97f4a7c15ull + (InHash << 6) + (InHash >> 2)));
+	}
+
+	/** Keys of these types are turned into their fingerprint without loss, so they never need to be verified. */
+	template <typename T>
+	inline constexpr bool TIsExactFingerprint_V = std::is_same_v<T, int32> || std::is_same_v<T, int64> || std::is_same_v<T, bool> || std::is_same_v<T, FName>;
+
+	uint64 GetNameFingerprint(FName InName)
+	{
+		// Names compare by comparison index and number, so packing both keeps the same equality
+		return (static_cast<uint64>(InName.GetComparisonIndex().ToUnstableInt()) << 32) | static_cast<uint32>(InName.GetNumber());
+	}
+
+	uint64 GetStringFingerprint(const FString& InString)
+	{
+		// FNV-1a over lower case characters, as strings compare case insensitively
+		uint64 Hash = 0xcbf29ce484222325ull;
+		for (const TCHAR* Char = *InString; *Char; ++Char)
+		{
+			Hash ^= static_cast<uint64>(FChar::ToLower(*Char));
+			Hash *= 0x100000001b3ull;
+		}
+
+		return Hash;
+	}
+
+	template <typename T>
+	uint64 GetFingerprint(const T& InValue)
+	{
+		if constexpr (std::is_same_v<T, int32> || std::is_same_v<T, int64> || std::is_same_v<T, bool>)
+		{
+			return static_cast<uint64>(InValue);
+		}
+		else if constexpr (std::is_same_v<T, FName>)
+		{
+			return GetNameFingerprint(InValue);
+		}
+		else if constexpr (std::is_same_v<T, FString>)
+		{
+			return GetStringFingerprint(InValue);
+		}
+		else if constexpr (std::is_base_of_v<FSoftObjectPath, T>)
+		{
+			// Fingerprinted from its parts, instead of building the full path string
+			uint64 Hash = GetNameFingerprint(InValue.GetAssetPath().GetPackageName());
+			Hash = Combine(Hash, GetNameFingerprint(InValue.GetAssetPath().GetAssetName()));
+			return Combine(Hash, GetStringFingerprint(InValue.GetSubPathString()));
+		}
+		else
+		{
+			return Mix(GetTypeHash(InValue));
+		}
+	}
+
+	template <typename T>
+	FString ToString(const T& InValue)
+	{
+		if constexpr (std::is_arithmetic_v<T>)
+		{
+			return LexToString(InValue);
+		}
+		else if constexpr (std::is_same_v<T, FString>)
+		{
+			return InValue;
+		}
+		else
+		{
+			return InValue.ToString();
+		}
+	}
+
+	/** Escapes the separators of keys as text with a backslash, so keys made of different values never read the same. */
+	FString EscapeKeyText(const FString& InText)
+	{
+		FString Escaped;
+		Escaped.Reserve(InText.Len());
+
+		for (const TCHAR Char : InText)
+		{
+			if (Char == TEXT('\\') || Char == TEXT(',') || Char == TEXT('='))
+			{
+				Escaped.AppendChar(TEXT('\\'));
+			}
+
+			Escaped.AppendChar(Char);
+		}
+
+		return Escaped;
+	}
+
+	template <typename T>
+	class TMatchKeyColumn final : public IMatchKeyColumn
+	{
+	public:
+		TArray<T> Values;
+
+		virtual bool Equals(int32 InIndex, const IMatchKeyColumn& InOther, int32 InOtherIndex) const override
+		{
+			return Values[InIndex] == static_cast<const TMatchKeyColumn&>(InOther).Values[InOtherIndex];
+		}
+
+		virtual FString ToString(int32 InIndex) const override
+		{
+			return MatchKeys::ToString(Values[InIndex]);
+		}
+	};
+}
+
+namespace UE::PCGPlus
+{
+	FMatchKeys::~FMatchKeys()
+	{
+		Reset();
+	}
+
+	bool FMatchKeys::Equals(int32 InIndex, const FMatchKeys& InOther, int32 InOtherIndex) const
+	{
+		if (IsExact())
+		{
+			return Fingerprints[InIndex] == InOther.Fingerprints[InOtherIndex];
+		}
+
+		check(Columns.Num() == InOther.Columns.Num());
+
+		for (int32 ColumnIdx = 0; ColumnIdx < Columns.Num(); ++ColumnIdx)
+		{
+			if (!Columns[ColumnIdx]->Equals(InIndex, *InOther.Columns[ColumnIdx], InOtherIndex))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	FString FMatchKeys::ToString(int32 InIndex) const
+	{
+		check(Columns.Num() == Types.Num());
+
+		TArray<FString> ColumnStrings;
+		ColumnStrings.Reserve(Columns.Num());
+		for (const TUniquePtr<IMatchKeyColumn>& Column : Columns)
+		{
+			ColumnStrings.Add(MatchKeys::EscapeKeyText(Column->ToString(InIndex)));
+		}
+
+		return FString::Join(ColumnStrings, TEXT(","));
+	}
+
+	bool FMatchKeys::Read(FPCGContext* Context, const UPCGData* InData, TArrayView<const FPCGAttributePropertyInputSelector> InSelectors, const FMatchKeys* InTypesFrom, bool bInKeepValues)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(UE::PCGPlus::FMatchKeys::Read);
+
+		Reset();
+
+		if (InSelectors.IsEmpty() || (InTypesFrom && InTypesFrom->Types.Num() != InSelectors.Num()))
+		{
+			PCGE_LOG_C(Error, GraphAndLog, Context, LOCTEXT("MismatchingMatchKeys", "Source and target must be matched on the same number of attributes/properties"));
+			return false;
+		}
+
+		for (int32 ColumnIdx = 0; ColumnIdx < InSelectors.Num(); ++ColumnIdx)
+		{
+			const FPCGAttributePropertyInputSelector Selector = InSelectors[ColumnIdx].CopyAndFixLast(InData);
+
+			TUniquePtr<const IPCGAttributeAccessor> Accessor = PCGAttributeAccessorHelpers::CreateConstAccessor(InData, Selector);
+			TUniquePtr<const IPCGAttributeAccessorKeys> Keys = PCGAttributeAccessorHelpers::CreateConstKeys(InData, Selector);
+
+			if (!Accessor.IsValid() || !Keys.IsValid())
+			{
+				PCGE_LOG_C(Error, GraphAndLog, Context, FText::Format(LOCTEXT("FailedToCreateMatchAccessor", "Failed to create match accessor or iterator for '{0}'"), Selector.GetDisplayText()));
+				return false;
+			}
+
+			if (ColumnIdx == 0)
+			{
+				Fingerprints = TScratchPool<uint64>::Acquire(Keys->GetNum());
+			}
+			else if (Keys->GetNum() != Fingerprints.Num())
+			{
+				PCGE_LOG_C(Error, GraphAndLog, Context, FText::Format(LOCTEXT("MismatchingMatchKeyCount", "Match attribute/property '{0}' does not have the same number of elements as the others"), Selector.GetDisplayText()));
+				return false;
+			}
+
+			const uint16 Type = InTypesFrom ? InTypesFrom->Types[ColumnIdx] : Accessor->GetUnderlyingType();
+			const bool bSingleColumn = InSelectors.Num() == 1;
+
+			auto ReadColumn = [this, Context, &Selector, &Accessor, &Keys, ColumnIdx, bSingleColumn, bInKeepValues](auto Dummy) -> bool
+			{
+				using KeyType = decltype(Dummy);
+
+				if constexpr (!TIsJoinKey_V<KeyType>)
+				{
+					PCGE_LOG_C(Error, GraphAndLog, Context, FText::Format(LOCTEXT("UnsupportedMatchType", "Attribute/Property '{0}' has a type that cannot be matched on"), Selector.GetDisplayText()));
+					return false;
+				}
+				else
+				{
+					TUniquePtr<MatchKeys::TMatchKeyColumn<KeyType>> Column = MakeUnique<MatchKeys::TMatchKeyColumn<KeyType>>();
+					Column->Values.SetNum(Keys->GetNum());
+
+					if (!Accessor->GetRange<KeyType>(Column->Values, 0, *Keys, EPCGAttributeAccessorFlags::AllowBroadcast | EPCGAttributeAccessorFlags::AllowConstructible))
+					{
+						PCGE_LOG_C(Error, GraphAndLog, Context, FText::Format(LOCTEXT("MatchReadFailed", "Failed to read match attribute/property '{0}', or it cannot be converted to the type of the source one"), Selector.GetDisplayText()));
+						return false;
+					}
+
+					const TArray<KeyType>& Values = Column->Values;
+					if (ColumnIdx == 0)
+					{
+						for (int32 Idx = 0; Idx < Values.Num(); ++Idx)
+						{
+							Fingerprints[Idx] = MatchKeys::GetFingerprint(Values[Idx]);
+						}
+					}
+					else
+					{
+						for (int32 Idx = 0; Idx < Values.Num(); ++Idx)
+						{
+							Fingerprints[Idx] = MatchKeys::Combine(Fingerprints[Idx], MatchKeys::GetFingerprint(Values[Idx]));
+						}
+					}
+
+					bExact = bSingleColumn && MatchKeys::TIsExactFingerprint_V<KeyType>;
+					if (!bExact || bInKeepValues)
+					{
+						Columns.Add(MoveTemp(Column));
+					}
+
+					return true;
+				}
+			};
+
+			if (!PCGMetadataAttribute::CallbackWithRightType(Type, ReadColumn))
+			{
+				Reset();
+				return false;
+			}
+
+			Types.Add(Type);
+		}
+
+		return true;
+	}
+
+	void FMatchKeys::Reset()
+	{
+		TScratchPool<uint64>::Release(MoveTemp(Fingerprints));
+		Types.Reset();
+		Columns.Reset();
+		bExact = false;
+	}
+
+	void VerifyMatches(const FMatchKeys& InSourceKeys, const FMatchKeys& InTargetKeys, FJoinResult& InOutResult, EJoinDuplicatePolicy InPolicy)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(UE::PCGPlus::VerifyMatches);
+
+		if (InSourceKeys.IsExact())
+		{
+			return;
+		}
+
+		// Unmatched targets have no source with the same fingerprint, so no source with the same key either
+		bool bAnyCollision = false;
+		for (int32 TargetIdx = 0; TargetIdx < InOutResult.TargetToSource.Num(); ++TargetIdx)
+		{
+			int32& SourceIdx = InOutResult.TargetToSource[TargetIdx];
+			if (SourceIdx == INDEX_NONE || InSourceKeys.Equals(SourceIdx, InTargetKeys, TargetIdx))
+			{
+				continue;
+			}
+
+			bAnyCollision = true;
+			SourceIdx = INDEX_NONE;
+
+			const int32 NumSources = InSourceKeys.Num();
+			for (int32 Step = 0; Step < NumSources; ++Step)
+			{
+				const int32 CandidateIdx = (InPolicy == EJoinDuplicatePolicy::First) ? Step : NumSources - 1 - Step;
+				if (InSourceKeys.Equals(CandidateIdx, InTargetKeys, TargetIdx))
+				{
+					SourceIdx = CandidateIdx;
+					break;
+				}
+			}
+		}
+
+		if (bAnyCollision)
+		{
+			InOutResult.UpdateCounts();
+		}
+	}
+
+	void GroupKeys(const FMatchKeys& InKeys, TArray<int32>& OutGroups)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(UE::PCGPlus::GroupKeys);
+
+		FJoinResult Groups = Join<uint64>(InKeys.Fingerprints, InKeys.Fingerprints, EJoinDuplicatePolicy::First);
+		VerifyMatches(InKeys, InKeys, Groups, EJoinDuplicatePolicy::First);
+		OutGroups = MoveTemp(Groups.TargetToSource);
+	}
+
+	FString GetKeySelectorsString(const UPCGData* InData, TArrayView<const FPCGAttributePropertyInputSelector> InSelectors)
+	{
+		TArray<FString> SelectorStrings;
+		SelectorStrings.Reserve(InSelectors.Num());
+		for (const FPCGAttributePropertyInputSelector& Selector : InSelectors)
+		{
+			SelectorStrings.Add(MatchKeys::EscapeKeyText(Selector.CopyAndFixLast(InData).GetDisplayText().ToString()));
+		}
+
+		return FString::Join(SelectorStrings, TEXT(","));
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,129 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Helpers/PCGNearestNeighbour.h"
+
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+#include <algorithm>
+
+namespace UE::PCGPlus
+{
+	void FKdTree::Build(TArrayView<const FVector> InPositions)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(UE::PCGPlus::FKdTree::Build);
+
+		Positions = TArray<FVector>(InPositions.GetData(), InPositions.Num());
+		Indices.SetNumUninitialized(InPositions.Num());
+		for (int32 Idx = 0; Idx < Indices.Num(); ++Idx)
+		{
+			Indices[Idx] = Idx;
+		}
+
+		Axes.SetNumZeroed(InPositions.Num());
+
+		BuildRange(0, Positions.Num());
+
+		// Positions are stored in tree order, so queries read them sequentially
+		for (int32 Idx = 0; Idx < Indices.Num(); ++Idx)
+		{
+			Positions[Idx] = InPositions[Indices[Idx]];
+		}
+	}
+
+	void FKdTree::BuildRange(int32 InBegin, int32 InEnd)
+	{
+		if (InEnd - InBegin <= LeafSize)
+		{
+			return;
+		}
+
+		FBox Bounds(ForceInit);
+		for (int32 Idx = InBegin; Idx < InEnd; ++Idx)
+		{
+			Bounds += Positions[Indices[Idx]];
+		}
+
+		const FVector Extent = Bounds.GetExtent();
+		const uint8 Axis = (Extent.X >= Extent.Y && Extent.X >= Extent.Z) ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+
+		const int32 Mid = InBegin + (InEnd - InBegin) / 2;
+		std::nth_element(Indices.GetData() + InBegin, Indices.GetData() + Mid, Indices.GetData() + InEnd, [this, Axis](int32 A, int32 B)
+		{
+			return Positions[A][Axis] < Positions[B][Axis];
+		});
+
+		Axes[Mid] = Axis;
+
+		BuildRange(InBegin, Mid);
+		BuildRange(Mid + 1, InEnd);
+	}
+
+	int32 FKdTree::FindNearest(const FVector& InQuery, double InMaxDistanceSquared) const
+	{
+		double BestDistanceSquared = InMaxDistanceSquared;
+		int32 BestIndex = INDEX_NONE;
+
+		SearchRange(0, Positions.Num(), InQuery, BestDistanceSquared, BestIndex);
+
+		return BestIndex;
+	}
+
+	void FKdTree::SearchRange(int32 InBegin, int32 InEnd, const FVector& InQuery, double& InOutBestDistanceSquared, int32& InOutBestIndex) const
+	{
+		auto Test = [this, &InQuery, &InOutBestDistanceSquared, &InOutBestIndex](int32 InIdx)
+		{
+			const double DistanceSquared = FVector::DistSquared(Positions[InIdx], InQuery);
+			if (DistanceSquared < InOutBestDistanceSquared
+				|| (DistanceSquared == InOutBestDistanceSquared && (InOutBestIndex == INDEX_NONE || Indices[InIdx] < InOutBestIndex)))
+			{
+				InOutBestDistanceSquared = DistanceSquared;
+				InOutBestIndex = Indices[InIdx];
+			}
+		};
+
+		if (InEnd - InBegin <= LeafSize)
+		{
+			for (int32 Idx = InBegin; Idx < InEnd; ++Idx)
+			{
+				Test(Idx);
+			}
+
+			return;
+		}
+
+		const int32 Mid = InBegin + (InEnd - InBegin) / 2;
+		const uint8 Axis = Axes[Mid];
+		const double Delta = InQuery[Axis] - Positions[Mid][Axis];
+
+		Test(Mid);
+
+		// The side of the query first, then the other one only if it can hold something as close
+		if (Delta < 0)
+		{
+			SearchRange(InBegin, Mid, InQuery, InOutBestDistanceSquared, InOutBestIndex);
+			if (Delta * Delta <= InOutBestDistanceSquared)
+			{
+				SearchRange(Mid + 1, InEnd, InQuery, InOutBestDistanceSquared, InOutBestIndex);
+			}
+		}
+		else
+		{
+			SearchRange(Mid + 1, InEnd, InQuery, InOutBestDistanceSquared, InOutBestIndex);
+			if (Delta * Delta <= InOutBestDistanceSquared)
+			{
+				SearchRange(InBegin, Mid, InQuery, InOutBestDistanceSquared, InOutBestIndex);
+			}
+		}
+	}
+
+	TUniquePtr<IJoinTask> MakeNearestJoinTask(TSharedPtr<const FKdTree> InSourceTree, TArray<FVector>&& InTargetPositions, double InMaxDistance)
+	{
+		check(InSourceTree.IsValid());
+		const double MaxDistanceSquared = InMaxDistance < 0 ? TNumericLimits<double>::Max() : InMaxDistance * InMaxDistance;
+
+		return MakeParallelProbeJoinTask(MoveTemp(InTargetPositions), [SourceTree = MoveTemp(InSourceTree), MaxDistanceSquared](const FVector& InPosition)
+		{
+			return SourceTree->FindNearest(InPosition, MaxDistanceSquared);
+		});
+	}
+}
@@ -0,0 +1,114 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Helpers/PCGRangeJoin.h"
+
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+#include <algorithm>
+
+namespace UE::PCGPlus
+{
+	void FRangeIndex::Build(TArrayView<const double> InMins, TArrayView<const double> InMaxs)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(UE::PCGPlus::FRangeIndex::Build);
+		check(InMins.Num() == InMaxs.Num());
+
+		// Ranges that cannot contain anything are left out, which also keeps NaNs out of the sort
+		Indices.Reset(InMins.Num());
+		for (int32 Idx = 0; Idx < InMins.Num(); ++Idx)
+		{
+			if (InMins[Idx] <= InMaxs[Idx])
+			{
+				Indices.Add(Idx);
+			}
+		}
+
+		std::sort(Indices.GetData(), Indices.GetData() + Indices.Num(), [&InMins](int32 A, int32 B)
+		{
+			return InMins[A] < InMins[B] || (InMins[A] == InMins[B] && A < B);
+		});
+
+		Mins.SetNumUninitialized(Indices.Num());
+		Maxs.SetNumUninitialized(Indices.Num());
+		for (int32 Idx = 0; Idx < Indices.Num(); ++Idx)
+		{
+			Mins[Idx] = InMins[Indices[Idx]];
+			Maxs[Idx] = InMaxs[Indices[Idx]];
+		}
+
+		SubtreeMaxs.SetNumUninitialized(Indices.Num());
+		BuildRange(0, Indices.Num());
+	}
+
+	double FRangeIndex::BuildRange(int32 InBegin, int32 InEnd)
+	{
+		if (InBegin == InEnd)
+		{
+			return -TNumericLimits<double>::Max();
+		}
+
+		const int32 Mid = InBegin + (InEnd - InBegin) / 2;
+		const double LeftMax = BuildRange(InBegin, Mid);
+		const double RightMax = BuildRange(Mid + 1, InEnd);
+
+		SubtreeMaxs[Mid] = FMath::Max3(LeftMax, RightMax, Maxs[Mid]);
+		return SubtreeMaxs[Mid];
+	}
+
+	int32 FRangeIndex::Find(double InValue, EJoinDuplicatePolicy InPolicy) const
+	{
+		// A NaN value is in no range
+		if (FMath::IsNaN(InValue))
+		{
+			return INDEX_NONE;
+		}
+
+		int32 BestIndex = INDEX_NONE;
+		SearchRange(0, Mins.Num(), InValue, InPolicy, BestIndex);
+
+		return BestIndex;
+	}
+
+	void FRangeIndex::SearchRange(int32 InBegin, int32 InEnd, double InValue, EJoinDuplicatePolicy InPolicy, int32& InOutBestIndex) const
+	{
+		if (InBegin == InEnd)
+		{
+			return;
+		}
+
+		const int32 Mid = InBegin + (InEnd - InBegin) / 2;
+		if (SubtreeMaxs[Mid] < InValue)
+		{
+			return;
+		}
+
+		SearchRange(InBegin, Mid, InValue, InPolicy, InOutBestIndex);
+
+		// The middle range and the ones after it start after the value
+		if (Mins[Mid] > InValue)
+		{
+			return;
+		}
+
+		if (Maxs[Mid] >= InValue)
+		{
+			const int32 Candidate = Indices[Mid];
+			if (InOutBestIndex == INDEX_NONE || (InPolicy == EJoinDuplicatePolicy::First ? Candidate < InOutBestIndex : Candidate > InOutBestIndex))
+			{
+				InOutBestIndex = Candidate;
+			}
+		}
+
+		SearchRange(Mid + 1, InEnd, InValue, InPolicy, InOutBestIndex);
+	}
+
+	TUniquePtr<IJoinTask> MakeRangeJoinTask(TSharedPtr<const FRangeIndex> InSourceIndex, TArray<double>&& InTargetValues, EJoinDuplicatePolicy InPolicy)
+	{
+		check(InSourceIndex.IsValid());
+
+		return MakeParallelProbeJoinTask(MoveTemp(InTargetValues), [SourceIndex = MoveTemp(InSourceIndex), InPolicy](double InValue)
+		{
+			return SourceIndex->Find(InValue, InPolicy);
+		});
+	}
+}
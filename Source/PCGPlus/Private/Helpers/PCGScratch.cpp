@@ -0,0 +1,129 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Helpers/PCGScratch.h"
+
+#include "HAL/IConsoleManager.h"
+#include "PCGPlusStats.h"
+
+#include <atomic>
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Scratch Allocations"), STAT_PCGPlus_ScratchAllocations, STATGROUP_PCGPlus);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Scratch Reuses"), STAT_PCGPlus_ScratchReuses, STATGROUP_PCGPlus);
+DECLARE_MEMORY_STAT(TEXT("Scratch Memory In Use"), STAT_PCGPlus_ScratchBytes, STATGROUP_PCGPlus);
+DECLARE_MEMORY_STAT(TEXT("Peak Scratch Memory"), STAT_PCGPlus_ScratchPeakBytes, STATGROUP_PCGPlus);
+DECLARE_MEMORY_STAT(TEXT("Scratch Memory Pooled"), STAT_PCGPlus_ScratchPooledBytes, STATGROUP_PCGPlus);
+
+namespace UE::PCGPlus::Scratch
+{
+	static TAutoConsoleVariable<int32> CVarMaxPooledMB(
+		TEXT("pcgplus.Scratch.MaxPooledMB"),
+		32,
+		TEXT("Memory, in MB, kept pooled over all threads for the temporaries of PCGPlus elements. 0 disables pooling."));
+
+	static std::atomic<int64> NumAllocations = 0;
+	static std::atomic<int64> NumReuses = 0;
+	static std::atomic<int64> BytesInUse = 0;
+	static std::atomic<int64> PeakBytesInUse = 0;
+	static std::atomic<int64> BytesPooled = 0;
+	static std::atomic<uint32> Generation = 0;
+
+	static void UpdatePeak(int64 InBytesInUse)
+	{
+		int64 Peak = PeakBytesInUse.load(std::memory_order_relaxed);
+		while (InBytesInUse > Peak && !PeakBytesInUse.compare_exchange_weak(Peak, InBytesInUse, std::memory_order_relaxed))
+		{
+		}
+
+		SET_MEMORY_STAT(STAT_PCGPlus_ScratchPeakBytes, PeakBytesInUse.load(std::memory_order_relaxed));
+	}
+
+	int64 GetMaxPooledBytes()
+	{
+		return static_cast<int64>(FMath::Max(CVarMaxPooledMB.GetValueOnAnyThread(), 0)) * 1024 * 1024;
+	}
+
+	void NotifyAcquired(int64 InBytes, bool bInAllocated)
+	{
+		if (bInAllocated)
+		{
+			NumAllocations.fetch_add(1, std::memory_order_relaxed);
+			INC_DWORD_STAT(STAT_PCGPlus_ScratchAllocations);
+		}
+		else
+		{
+			NumReuses.fetch_add(1, std::memory_order_relaxed);
+			INC_DWORD_STAT(STAT_PCGPlus_ScratchReuses);
+		}
+
+		const int64 InUse = BytesInUse.fetch_add(InBytes, std::memory_order_relaxed) + InBytes;
+		SET_MEMORY_STAT(STAT_PCGPlus_ScratchBytes, InUse);
+		UpdatePeak(InUse);
+	}
+
+	void NotifyReleased(int64 InBytes)
+	{
+		// An array grown after being acquired releases more than it acquired, so the count is kept from going negative
+		int64 InUse = BytesInUse.load(std::memory_order_relaxed);
+		while (!BytesInUse.compare_exchange_weak(InUse, FMath::Max<int64>(InUse - InBytes, 0), std::memory_order_relaxed))
+		{
+		}
+
+		SET_MEMORY_STAT(STAT_PCGPlus_ScratchBytes, FMath::Max<int64>(InUse - InBytes, 0));
+	}
+
+	bool TryPool(int64 InBytes)
+	{
+		const int64 MaxBytes = GetMaxPooledBytes();
+
+		int64 Pooled = BytesPooled.load(std::memory_order_relaxed);
+		do
+		{
+			if (Pooled + InBytes > MaxBytes)
+			{
+				return false;
+			}
+		}
+		while (!BytesPooled.compare_exchange_weak(Pooled, Pooled + InBytes, std::memory_order_relaxed));
+
+		SET_MEMORY_STAT(STAT_PCGPlus_ScratchPooledBytes, Pooled + InBytes);
+		return true;
+	}
+
+	void NotifyUnpooled(int64 InBytes)
+	{
+		const int64 Pooled = BytesPooled.fetch_sub(InBytes, std::memory_order_relaxed) - InBytes;
+		SET_MEMORY_STAT(STAT_PCGPlus_ScratchPooledBytes, Pooled);
+	}
+
+	uint32 GetGeneration()
+	{
+		return Generation.load(std::memory_order_relaxed);
+	}
+
+	void Trim()
+	{
+		Generation.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	static FAutoConsoleCommand CmdTrim(
+		TEXT("pcgplus.Scratch.Trim"),
+		TEXT("Frees the memory pooled for the temporaries of PCGPlus elements."),
+		FConsoleCommandDelegate::CreateStatic(&Trim));
+
+	FScratchStats GetStats()
+	{
+		FScratchStats Stats;
+		Stats.NumAllocations = NumAllocations.load(std::memory_order_relaxed);
+		Stats.NumReuses = NumReuses.load(std::memory_order_relaxed);
+		Stats.BytesInUse = BytesInUse.load(std::memory_order_relaxed);
+		Stats.PeakBytesInUse = PeakBytesInUse.load(std::memory_order_relaxed);
+		Stats.BytesPooled = BytesPooled.load(std::memory_order_relaxed);
+		return Stats;
+	}
+
+	void ResetPeak()
+	{
+		PeakBytesInUse.store(BytesInUse.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		SET_MEMORY_STAT(STAT_PCGPlus_ScratchPeakBytes, PeakBytesInUse.load(std::memory_order_relaxed));
+	}
+}
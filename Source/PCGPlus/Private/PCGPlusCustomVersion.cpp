@@ -0,0 +1,9 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PCGPlusCustomVersion.h"
+
+#include "Serialization/CustomVersion.h"
+
+const FGuid FPCGPlusCustomVersion::GUID(0xC53AECC5, 0xA5254DB6, 0x9B1AEA33, 0x287CED7C);
+
+FCustomVersionRegistration GRegisterPCGPlusCustomVersion(FPCGPlusCustomVersion::GUID, FPCGPlusCustomVersion::LatestVersion, TEXT("PCGPlusVersion"));
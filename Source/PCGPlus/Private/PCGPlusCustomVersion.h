@@ -0,0 +1,26 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/Guid.h"
+
+/** Versions of the PCGPlus settings saved in assets. */
+struct FPCGPlusCustomVersion
+{
+	enum Type
+	{
+		BeforeCustomVersionWasAdded = 0,
+
+		/** Copy Attribute picks how points are matched with MatchMode, instead of bMatchByAttribute. */
+		CopyAttributeMatchMode,
+
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	static const FGuid GUID;
+
+private:
+	FPCGPlusCustomVersion() = default;
+};
@@ -6,8 +6,108 @@
 
 #include "PCGCopyAttributeElement.generated.h"
 
+UENUM()
+enum class EPCGCopyAttributeOutputMode : uint8
+{
+	/** Each written target point gets its own metadata entry in the output. */
+	NewEntries,
+	/** Target points keep the entries of the target, and only the copied attribute columns are written to the output metadata, which is parented to the target's. */
+	InheritEntries
+};
+
+UENUM()
+enum class EPCGCopyAttributeMatchMode : uint8
+{
+	/** Each target point is copied to from the source point at the same index. Both must have the same number of points. */
+	Index,
+	/** Each target point is copied to from the source point with the same match values. */
+	Attribute,
+	/** Each target point is copied to from the source point nearest to it. */
+	Nearest,
+	/**
+	 * Each target point is copied to from the source sampled at its transform and bounds, so the source can be any spatial data (surface, volume, landscape...).
+	 * Target points the source has no sample for have no match.
+	 */
+	Sample,
+	/**
+	 * Each target point is copied to from the source point whose range contains the target's match value, both read as doubles.
+	 * Joins quantized floats, like height bands, distance rings or seeds stored as floats, that rarely compare equal.
+	 */
+	Range
+};
+
+UENUM()
+enum class EPCGCopyAttributeRangeMode : uint8
+{
+	/** The range of each source point is its match value, plus or minus the tolerance. */
+	Tolerance,
+	/** The range of each source point goes from its match value to its range max value. */
+	Interval
+};
+
+UENUM()
+enum class EPCGCopyAttributeJoinMode : uint8
+{
+	/**
+	 * Target points without a match are kept. The copied attribute keeps its current value on them, or its default value if the copy created it.
+	 * Copies into an attribute the target already has then go through accessors, even between plain attributes.
+	 */
+	Left,
+	/** Target points without a match are removed from the output. */
+	Inner
+};
+
+UENUM()
+enum class EPCGCopyAttributeDuplicatePolicy : uint8
+{
+	/** Copy from the first source point with the match value. */
+	First,
+	/** Copy from the last source point with the match value. */
+	Last
+};
+
+UENUM()
+enum class EPCGCopyAttributeAggregation : uint8
+{
+	/** Copy from a single source point, picked by the duplicate policy. */
+	None,
+	Sum,
+	Min,
+	Max,
+	Mean,
+	/** Number of source points with the match value. Creates an integer attribute when the target does not exist yet. */
+	Count
+};
+
+/** One more source attribute/property to copy to a target attribute/property. */
+USTRUCT(BlueprintType)
+struct PCGPLUS_API FPCGCopyAttributeMapping
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings")
+	FPCGAttributePropertyInputSelector SourceAttributeProperty;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings")
+	FPCGAttributePropertyOutputSelector TargetAttributeProperty;
+};
+
+/** One more pair of attributes/properties that must have equal values for a target point to match a source point. */
+USTRUCT(BlueprintType)
+struct PCGPLUS_API FPCGCopyAttributeMatchKey
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings")
+	FPCGAttributePropertyInputSelector SourceMatchAttributeProperty;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings")
+	FPCGAttributePropertyInputSelector TargetMatchAttributeProperty;
+};
+
 /**
- * Copy one or more attributes from another source, by matching an attribute value (instead of by index)
+ * Copy one or more attributes from another source, by matching an attribute value or the nearest point (instead of by index)
+ * With several sources, each target is copied from the source sharing the most tags with it, like the outputs of Partition By Attribute on the same values.
  */
 UCLASS()
 class PCGPLUS_API UPCGCopyAttributeSettings : public UPCGSettings
@@ -15,6 +115,11 @@ class PCGPLUS_API UPCGCopyAttributeSettings : public UPCGSettings
 	GENERATED_BODY()
 
 public:
+	//~Begin UObject interface
+	virtual void Serialize(FArchive& Ar) override;
+	virtual void PostLoad() override;
+	//~End UObject interface
+
 	//~Begin UPCGSettings interface
 #if WITH_EDITOR
 	virtual FName GetDefaultNodeName() const override;
@@ -39,21 +144,134 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings")
 	FPCGAttributePropertyOutputSelector TargetAttributeProperty;
 
+	/** Copied after the main attribute, into the same output and through the same match. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings")
+	TArray<FPCGCopyAttributeMapping> AdditionalMappings;
+
+	/** How target points are paired with source points. Only applies to target points. Sources that are not points are always sampled. */
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings")
-	bool bMatchByAttribute = true;
+	EPCGCopyAttributeMatchMode MatchMode = EPCGCopyAttributeMatchMode::Attribute;
 
-	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (EditCondition = "bMatchByAttribute"))
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (EditCondition = "MatchMode == EPCGCopyAttributeMatchMode::Attribute || MatchMode == EPCGCopyAttributeMatchMode::Range"))
 	FPCGAttributePropertyInputSelector SourceMatchAttributeProperty;
 
-	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (EditCondition = "bMatchByAttribute"))
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (EditCondition = "MatchMode == EPCGCopyAttributeMatchMode::Attribute || MatchMode == EPCGCopyAttributeMatchMode::Range"))
 	FPCGAttributePropertyInputSelector TargetMatchAttributeProperty;
+
+	/** Points only match when these values are equal too, for keys made of several attributes/properties. Any metadata type can be matched on. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (EditCondition = "MatchMode == EPCGCopyAttributeMatchMode::Attribute"))
+	TArray<FPCGCopyAttributeMatchKey> AdditionalMatchKeys;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (InlineEditConditionToggle))
+	bool bUseMaxDistance = false;
+
+	/** When matching the nearest point, target points farther than this from every source point have no match. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (EditCondition = "bUseMaxDistance", ClampMin = "0"))
+	double MaxDistance = 100.0;
+
+	/** How the range of each source point is made from its match value. Ranges include both their ends. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (EditCondition = "MatchMode == EPCGCopyAttributeMatchMode::Range"))
+	EPCGCopyAttributeRangeMode RangeMode = EPCGCopyAttributeRangeMode::Tolerance;
+
+	/** Largest difference between a target value and a source value for them to match. Zero still matches equal values. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (EditCondition = "MatchMode == EPCGCopyAttributeMatchMode::Range && RangeMode == EPCGCopyAttributeRangeMode::Tolerance", ClampMin = "0"))
+	double MatchTolerance = 0.001;
+
+	/** End of the range of each source point, which starts at its match value. Source points whose range ends before it starts never match. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (EditCondition = "MatchMode == EPCGCopyAttributeMatchMode::Range && RangeMode == EPCGCopyAttributeRangeMode::Interval"))
+	FPCGAttributePropertyInputSelector SourceRangeMaxAttributeProperty;
+
+	/** What happens to target points without a match. When matching, source and target can have different numbers of points. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (EditCondition = "MatchMode != EPCGCopyAttributeMatchMode::Index"))
+	EPCGCopyAttributeJoinMode JoinMode = EPCGCopyAttributeJoinMode::Left;
+
+	/** Which source point is copied from when several have the same match value, or when several ranges contain it. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (EditCondition = "(MatchMode == EPCGCopyAttributeMatchMode::Attribute && Aggregation == EPCGCopyAttributeAggregation::None) || MatchMode == EPCGCopyAttributeMatchMode::Range"))
+	EPCGCopyAttributeDuplicatePolicy DuplicatePolicy = EPCGCopyAttributeDuplicatePolicy::First;
+
+	/** Combine the values of all the source points with the match value, instead of copying from one of them. Only numeric and vector values can be combined. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (EditCondition = "MatchMode == EPCGCopyAttributeMatchMode::Attribute"))
+	EPCGCopyAttributeAggregation Aggregation = EPCGCopyAttributeAggregation::None;
+
+	/**
+	 * When the source is also the target, move attributes within the output instead of copying their values, for attribute to attribute mappings.
+	 * The output keeps reading the values of the target, so no value is copied. The points of the target are still duplicated into the output.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (EditCondition = "MatchMode == EPCGCopyAttributeMatchMode::Index"))
+	bool bMoveInPlace = false;
+
+	/** Whether a moved attribute is removed from the output, or kept alongside the new one, sharing its values. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (EditCondition = "bMoveInPlace && MatchMode == EPCGCopyAttributeMatchMode::Index"))
+	bool bDeleteMovedAttribute = true;
+
+	/**
+	 * How the output metadata relates to the target's. Only affects attribute to attribute copies between points, which write value keys directly.
+	 * Other copies go through accessors, which create entries as they write. Written points that share an entry are given one of their own in both modes.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings|Performance")
+	EPCGCopyAttributeOutputMode OutputMode = EPCGCopyAttributeOutputMode::NewEntries;
+
+	/**
+	 * For attribute to attribute copies between points, only copy the values the target points use, each once, instead of the whole value table of the source attribute.
+	 * Worth it for attributes with few distinct values over many points, like names, strings or soft object paths.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings|Performance")
+	bool bDeduplicateValues = false;
+
+	/**
+	 * Keep the source point matched by each target point in a shared cache, keyed by the source and target data, the match attributes/properties, the max distance or tolerance, and the duplicate policy.
+	 * Later executions on the same data skip straight to copying values. Samples are never cached. The cache holds 64 MB by default, set by pcgplus.JoinCache.BudgetMB.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings|Performance", meta = (EditCondition = "MatchMode != EPCGCopyAttributeMatchMode::Index && MatchMode != EPCGCopyAttributeMatchMode::Sample"))
+	bool bCacheMatch = true;
+
+	/**
+	 * Number of elements processed by each parallel task when reading and gathering values, or when gathering the entries of the points for a copy between attributes.
+	 * Properties are written by the same tasks. An attribute is written with a single serial call per slice, once all its values are gathered.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings|Performance", meta = (ClampMin = "256"))
+	int32 BatchSize = 16384;
+
+	/**
+	 * Adds attributes prefixed with PCGPlus_ to each output, describing how it was copied: copy path, match path, matched and unmatched points, bytes copied and time spent.
+	 * They only have a default value, so they cost nothing per point.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings|Debug", AdvancedDisplay)
+	bool bOutputDebugInfo = false;
+
+#if WITH_EDITORONLY_DATA
+	UPROPERTY()
+	bool bMatchByAttribute_DEPRECATED = true;
+#endif
 };
 
-class FPCGCopyAttributeElement : public FSimplePCGElement
+struct FPCGCopyAttributeContext;
+struct FPCGCopyAttributeOperation;
+struct FPCGCopyAttributeTarget;
+
+class FPCGCopyAttributeElement : public IPCGElement
 {
+public:
+	virtual FPCGContext* Initialize(const FPCGDataCollection& InputData, TWeakObjectPtr<UPCGComponent> SourceComponent, const UPCGNode* Node) override;
+
 protected:
-	virtual bool ExecuteInternal(FPCGContext* Context) const override;
+	virtual bool ExecuteInternal(FPCGContext* InContext) const override;
 
 private:
+	/** Validates the inputs, creates one output per target and prepares their operations and matches. */
+	void PrepareCopy(FPCGCopyAttributeContext* Context) const;
+
+	/** Validates a single mapping and adds its operation to the target, if there is anything to copy. Returns false on error. */
+	bool PrepareOperation(FPCGCopyAttributeContext* Context, FPCGCopyAttributeTarget& Target, const FPCGAttributePropertyInputSelector& InSourceAttributeProperty, const FPCGAttributePropertyOutputSelector& InTargetAttributeProperty) const;
+
+	/** Runs the next slice of a target. Called from worker threads, so it neither checks the time budget nor logs. */
+	void ExecuteTarget(FPCGCopyAttributeContext* Context, FPCGCopyAttributeTarget& Target) const;
+
+	/** Each runs a single slice, and returns false while there are slices left. */
+	bool MatchPoints(FPCGCopyAttributeContext* Context, FPCGCopyAttributeTarget& Target) const;
+	bool CopyValueKeys(FPCGCopyAttributeContext* Context, FPCGCopyAttributeTarget& Target, FPCGCopyAttributeOperation& Operation) const;
+	bool CopyValues(FPCGCopyAttributeContext* Context, FPCGCopyAttributeTarget& Target, FPCGCopyAttributeOperation& Operation) const;
 
+	/** For inner joins, removes the output points that had no match, once everything has been copied. */
+	void RemoveUnmatchedPoints(FPCGCopyAttributeTarget& Target) const;
 };
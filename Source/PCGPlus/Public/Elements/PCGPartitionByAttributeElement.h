@@ -0,0 +1,66 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Metadata/PCGAttributePropertySelector.h"
+#include "PCGContext.h"
+#include "PCGElement.h"
+#include "PCGSettings.h"
+
+#include "PCGPartitionByAttributeElement.generated.h"
+
+/**
+ * Splits each input point data into one output per distinct value of an attribute/property, in a single pass over the points.
+ * Outputs are tagged with their value, so Copy Attribute can pair them with the outputs of another partition on the same values.
+ */
+UCLASS()
+class PCGPLUS_API UPCGPartitionByAttributeSettings : public UPCGSettings
+{
+	GENERATED_BODY()
+
+public:
+	//~Begin UPCGSettings interface
+#if WITH_EDITOR
+	virtual FName GetDefaultNodeName() const override;
+	virtual FText GetDefaultNodeTitle() const override;
+	virtual EPCGSettingsType GetType() const override { return EPCGSettingsType::Filter; }
+	virtual FText GetNodeTooltipText() const override;
+#endif
+	virtual FName AdditionalTaskName() const override;
+
+protected:
+	virtual TArray<FPCGPinProperties> InputPinProperties() const override;
+	virtual TArray<FPCGPinProperties> OutputPinProperties() const override;
+	virtual FPCGElementPtr CreateElement() const override;
+	//~End UPCGSettings interface
+
+public:
+	/** Points with equal values go to the same output. Any metadata type can be partitioned on. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings")
+	FPCGAttributePropertyInputSelector PartitionAttributeProperty;
+
+	/** Points only go to the same output when these values are equal too, for partitions on several attributes/properties. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings")
+	TArray<FPCGAttributePropertyInputSelector> AdditionalPartitionAttributeProperties;
+
+	/**
+	 * Tags each output with its value, as Attribute=Value, with the values of several attributes/properties separated by commas.
+	 * Commas, equal signs and backslashes in names and values are escaped with a backslash.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings")
+	bool bTagOutputs = true;
+
+	/** Inputs with more distinct values than this are not partitioned, as each value creates a new data. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings", meta = (ClampMin = "1"))
+	int32 MaxPartitions = 1024;
+
+	/** Number of points counted and scattered by each parallel task. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Settings|Performance", meta = (ClampMin = "256"))
+	int32 BatchSize = 65536;
+};
+
+class FPCGPartitionByAttributeElement : public FSimplePCGElement
+{
+protected:
+	virtual bool ExecuteInternal(FPCGContext* Context) const override;
+};
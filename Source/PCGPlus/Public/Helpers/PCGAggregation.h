@@ -0,0 +1,120 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+#include <type_traits>
+
+namespace UE::PCGPlus
+{
+	/** How the values of all the elements sharing a key are combined. */
+	enum class EAggregation : uint8
+	{
+		Sum,
+		Min,
+		Max,
+		Mean,
+		Count
+	};
+
+	/** Whether values of this type can be aggregated. Vectors are aggregated per component. */
+	template <typename T>
+	inline constexpr bool TIsAggregatable_V = std::is_same_v<T, int32>
+		|| std::is_same_v<T, int64>
+		|| std::is_same_v<T, float>
+		|| std::is_same_v<T, double>
+		|| std::is_same_v<T, FVector2D>
+		|| std::is_same_v<T, FVector>
+		|| std::is_same_v<T, FVector4>;
+
+	namespace Aggregation
+	{
+		template <typename T>
+		T Min(const T& A, const T& B) { return FMath::Min(A, B); }
+		inline FVector2D Min(const FVector2D& A, const FVector2D& B) { return FVector2D(FMath::Min(A.X, B.X), FMath::Min(A.Y, B.Y)); }
+		inline FVector Min(const FVector& A, const FVector& B) { return A.ComponentMin(B); }
+		inline FVector4 Min(const FVector4& A, const FVector4& B) { return FVector4(FMath::Min(A.X, B.X), FMath::Min(A.Y, B.Y), FMath::Min(A.Z, B.Z), FMath::Min(A.W, B.W)); }
+
+		template <typename T>
+		T Max(const T& A, const T& B) { return FMath::Max(A, B); }
+		inline FVector2D Max(const FVector2D& A, const FVector2D& B) { return FVector2D(FMath::Max(A.X, B.X), FMath::Max(A.Y, B.Y)); }
+		inline FVector Max(const FVector& A, const FVector& B) { return A.ComponentMax(B); }
+		inline FVector4 Max(const FVector4& A, const FVector4& B) { return FVector4(FMath::Max(A.X, B.X), FMath::Max(A.Y, B.Y), FMath::Max(A.Z, B.Z), FMath::Max(A.W, B.W)); }
+
+		template <typename T>
+		T Divide(const T& A, int32 InCount) { return A / static_cast<T>(InCount); }
+		inline FVector2D Divide(const FVector2D& A, int32 InCount) { return A / static_cast<double>(InCount); }
+		inline FVector Divide(const FVector& A, int32 InCount) { return A / static_cast<double>(InCount); }
+		inline FVector4 Divide(const FVector4& A, int32 InCount) { return A * (1.0 / static_cast<double>(InCount)); }
+
+		/** The count is written to every component of vectors. */
+		template <typename T>
+		T FromCount(int32 InCount) { return static_cast<T>(InCount); }
+		template <> inline FVector2D FromCount<FVector2D>(int32 InCount) { return FVector2D(static_cast<double>(InCount)); }
+		template <> inline FVector FromCount<FVector>(int32 InCount) { return FVector(static_cast<double>(InCount)); }
+		template <> inline FVector4 FromCount<FVector4>(int32 InCount) { const double Count = InCount; return FVector4(Count, Count, Count, Count); }
+	}
+
+	/**
+	 * Reduces the values of each group into the first element of the group, in a single pass over the values.
+	 * InGroups maps each element to the first element with the same key, as given by joining a key column against itself with the First policy.
+	 * Only the values of the first elements are meaningful afterwards.
+	 */
+	template <typename T>
+	void AggregateGroupsInPlace(TArrayView<T> InOutValues, TArrayView<const int32> InGroups, EAggregation InAggregation)
+	{
+		static_assert(TIsAggregatable_V<T>, "T must be a numeric or vector type.");
+		check(InOutValues.Num() == InGroups.Num());
+		TRACE_CPUPROFILER_EVENT_SCOPE(UE::PCGPlus::AggregateGroupsInPlace);
+
+		const int32 Num = InOutValues.Num();
+
+		auto Reduce = [InOutValues, InGroups, Num](auto&& Op)
+		{
+			for (int32 Idx = 0; Idx < Num; ++Idx)
+			{
+				const int32 GroupIdx = InGroups[Idx];
+				if (GroupIdx != Idx)
+				{
+					InOutValues[GroupIdx] = Op(InOutValues[GroupIdx], InOutValues[Idx]);
+				}
+			}
+		};
+
+		switch (InAggregation)
+		{
+		case EAggregation::Sum:
+		case EAggregation::Mean:
+			Reduce([](const T& A, const T& B) { return A + B; });
+			break;
+		case EAggregation::Min:
+			Reduce([](const T& A, const T& B) { return Aggregation::Min(A, B); });
+			break;
+		case EAggregation::Max:
+			Reduce([](const T& A, const T& B) { return Aggregation::Max(A, B); });
+			break;
+		default:
+			break;
+		}
+
+		if (InAggregation == EAggregation::Mean || InAggregation == EAggregation::Count)
+		{
+			TArray<int32> Counts;
+			Counts.SetNumZeroed(Num);
+			for (const int32 GroupIdx : InGroups)
+			{
+				++Counts[GroupIdx];
+			}
+
+			for (int32 Idx = 0; Idx < Num; ++Idx)
+			{
+				if (InGroups[Idx] == Idx)
+				{
+					InOutValues[Idx] = (InAggregation == EAggregation::Mean) ? Aggregation::Divide(InOutValues[Idx], Counts[Idx]) : Aggregation::FromCount<T>(Counts[Idx]);
+				}
+			}
+		}
+	}
+}
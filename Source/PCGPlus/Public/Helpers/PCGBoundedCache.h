@@ -0,0 +1,106 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeLock.h"
+
+namespace UE::PCGPlus
+{
+	/**
+	 * Shared values kept under a memory budget, evicting the least recently used ones once over it.
+	 * Values larger than the whole budget are not kept. Thread safe.
+	 */
+	template <typename KeyType, typename ValueType>
+	class TBoundedCache
+	{
+	public:
+		TSharedPtr<const ValueType> Find(const KeyType& InKey)
+		{
+			FScopeLock ScopeLock(&Lock);
+
+			if (FEntry* Entry = Entries.Find(InKey))
+			{
+				Entry->LastUsed = ++UseCounter;
+				return Entry->Value;
+			}
+
+			return nullptr;
+		}
+
+		/** Replaces the value of the key, counting InSize bytes for it. */
+		void Add(const KeyType& InKey, TSharedPtr<const ValueType> InValue, int64 InSize, int64 InBudget)
+		{
+			check(InValue.IsValid());
+
+			FScopeLock ScopeLock(&Lock);
+
+			FEntry Existing;
+			if (Entries.RemoveAndCopyValue(InKey, Existing))
+			{
+				TotalSize -= Existing.Size;
+			}
+
+			if (InSize > InBudget)
+			{
+				return;
+			}
+
+			FEntry& Entry = Entries.Add(InKey);
+			Entry.Value = MoveTemp(InValue);
+			Entry.Size = InSize;
+			Entry.LastUsed = ++UseCounter;
+			TotalSize += InSize;
+
+			EvictToBudget(InBudget);
+		}
+
+		void Empty()
+		{
+			FScopeLock ScopeLock(&Lock);
+
+			Entries.Empty();
+			TotalSize = 0;
+		}
+
+		int64 GetAllocatedSize() const
+		{
+			FScopeLock ScopeLock(&Lock);
+			return TotalSize;
+		}
+
+	private:
+		/** Must be called with the lock held. */
+		void EvictToBudget(int64 InBudget)
+		{
+			// Few values are alive at once, so a scan for the oldest entry is cheaper than maintaining an ordered list.
+			while (TotalSize > InBudget && !Entries.IsEmpty())
+			{
+				const TPair<KeyType, FEntry>* Oldest = nullptr;
+				for (const TPair<KeyType, FEntry>& Pair : Entries)
+				{
+					if (!Oldest || Pair.Value.LastUsed < Oldest->Value.LastUsed)
+					{
+						Oldest = &Pair;
+					}
+				}
+
+				TotalSize -= Oldest->Value.Size;
+				Entries.Remove(KeyType(Oldest->Key));
+			}
+		}
+
+		struct FEntry
+		{
+			TSharedPtr<const ValueType> Value;
+			int64 Size = 0;
+			uint64 LastUsed = 0;
+		};
+
+		mutable FCriticalSection Lock;
+		TMap<KeyType, FEntry> Entries;
+		int64 TotalSize = 0;
+		uint64 UseCounter = 0;
+	};
+}
@@ -0,0 +1,90 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Metadata/Accessors/IPCGAttributeAccessor.h"
+#include "Metadata/PCGMetadataAttributeTraits.h"
+
+#include <type_traits>
+
+namespace UE::PCGPlus
+{
+	/** Whether values of this type can be converted in bulk by ConvertRange. */
+	template <typename ValueType>
+	inline constexpr bool TIsBulkConvertible_V = std::is_same_v<ValueType, int32> || std::is_same_v<ValueType, int64> || std::is_same_v<ValueType, float> || std::is_same_v<ValueType, double>;
+
+	/** Converts a range of numeric values to another numeric type, in a loop the compiler can vectorize. */
+	template <typename InType, typename OutType>
+	void ConvertRange(TArrayView<const InType> InValues, TArrayView<OutType> OutValues)
+	{
+		static_assert(TIsBulkConvertible_V<InType> && TIsBulkConvertible_V<OutType>, "Only numeric types can be converted in bulk.");
+		check(InValues.Num() == OutValues.Num());
+
+		const InType* RESTRICT In = InValues.GetData();
+		OutType* RESTRICT Out = OutValues.GetData();
+		const int32 Num = InValues.Num();
+
+		for (int32 Idx = 0; Idx < Num; ++Idx)
+		{
+			Out[Idx] = static_cast<OutType>(In[Idx]);
+		}
+	}
+
+	/** Whether a range read from an accessor of InType into OutType can go through ReadConvertedRange. */
+	inline bool CanReadConvertedRange(uint16 InType, uint16 OutType)
+	{
+		auto IsBulkConvertible = [](uint16 Type)
+		{
+			return Type == PCG::Private::MetadataTypes<int32>::Id
+				|| Type == PCG::Private::MetadataTypes<int64>::Id
+				|| Type == PCG::Private::MetadataTypes<float>::Id
+				|| Type == PCG::Private::MetadataTypes<double>::Id;
+		};
+
+		return InType != OutType && IsBulkConvertible(InType) && IsBulkConvertible(OutType) && PCG::Private::IsBroadcastableOrConstructible(InType, OutType);
+	}
+
+	/** Reads a range in the accessor's own type and converts it with ConvertRange. Expects CanReadConvertedRange to be true. */
+	template <typename OutType>
+	bool ReadConvertedRange(const IPCGAttributeAccessor& InAccessor, const IPCGAttributeAccessorKeys& InKeys, int32 InIndex, TArrayView<OutType> OutValues)
+	{
+		static_assert(TIsBulkConvertible_V<OutType>, "Only numeric types can be converted in bulk.");
+
+		auto ReadAndConvert = [&InAccessor, &InKeys, InIndex, OutValues](auto Dummy) -> bool
+		{
+			using InType = decltype(Dummy);
+
+			TArray<InType, TInlineAllocator<256>> InValues;
+			InValues.SetNumUninitialized(OutValues.Num());
+
+			if (!InAccessor.GetRange<InType>(InValues, InIndex, InKeys))
+			{
+				return false;
+			}
+
+			ConvertRange<InType, OutType>(InValues, OutValues);
+			return true;
+		};
+
+		const uint16 InType = InAccessor.GetUnderlyingType();
+		if (InType == PCG::Private::MetadataTypes<int32>::Id)
+		{
+			return ReadAndConvert(int32{});
+		}
+		else if (InType == PCG::Private::MetadataTypes<int64>::Id)
+		{
+			return ReadAndConvert(int64{});
+		}
+		else if (InType == PCG::Private::MetadataTypes<float>::Id)
+		{
+			return ReadAndConvert(float{});
+		}
+		else if (InType == PCG::Private::MetadataTypes<double>::Id)
+		{
+			return ReadAndConvert(double{});
+		}
+
+		return false;
+	}
+}
@@ -0,0 +1,59 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Helpers/PCGBoundedCache.h"
+#include "Helpers/PCGJoinIndex.h"
+
+namespace UE::PCGPlus
+{
+	/**
+	 * Identifies a join by the data on both sides, the selectors the keys were read with and how duplicate keys are resolved.
+	 * PCG data is immutable once created and its UID is never reused, so the same key always yields the same join.
+	 */
+	struct FJoinCacheKey
+	{
+		uint64 SourceUID = 0;
+		uint64 TargetUID = 0;
+		FString SourceSelector;
+		FString TargetSelector;
+		EJoinDuplicatePolicy DuplicatePolicy = EJoinDuplicatePolicy::First;
+
+		bool operator==(const FJoinCacheKey& Other) const
+		{
+			return SourceUID == Other.SourceUID
+				&& TargetUID == Other.TargetUID
+				&& SourceSelector == Other.SourceSelector
+				&& TargetSelector == Other.TargetSelector
+				&& DuplicatePolicy == Other.DuplicatePolicy;
+		}
+
+		friend uint32 GetTypeHash(const FJoinCacheKey& Key)
+		{
+			uint32 Hash = HashCombine(GetTypeHash(Key.SourceUID), GetTypeHash(Key.TargetUID));
+			Hash = HashCombine(Hash, GetTypeHash(Key.SourceSelector));
+			Hash = HashCombine(Hash, GetTypeHash(Key.TargetSelector));
+			return HashCombine(Hash, GetTypeHash(static_cast<uint8>(Key.DuplicatePolicy)));
+		}
+	};
+
+	/**
+	 * Join results shared across executions, evicting the least recently used ones once over the memory budget.
+	 * The budget is set by pcgplus.JoinCache.BudgetMB. Thread safe.
+	 */
+	class PCGPLUS_API FJoinCache
+	{
+	public:
+		static FJoinCache& Get();
+
+		TSharedPtr<const FJoinResult> Find(const FJoinCacheKey& InKey);
+		void Add(const FJoinCacheKey& InKey, TSharedPtr<const FJoinResult> InResult);
+		void Empty();
+
+		int64 GetAllocatedSize() const;
+
+	private:
+		TBoundedCache<FJoinCacheKey, FJoinResult> Cache;
+	};
+}
@@ -0,0 +1,533 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/ParallelFor.h"
+#include "Helpers/PCGRadixSort.h"
+#include "Helpers/PCGScratch.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Templates/Models.h"
+
+namespace UE::PCGPlus
+{
+	/** Whether values of this type can be used as keys of a join index. */
+	template <typename KeyType>
+	inline constexpr bool TIsJoinKey_V = TModels<CGetTypeHashable, KeyType>::Value;
+
+	/** Below this many keys on the smallest side, hashing the smallest side and streaming the other one beats sorting both. */
+	constexpr int32 RadixJoinThreshold = 64 * 1024;
+
+	/** Which source element a target element matches, when several source elements share its key. */
+	enum class EJoinDuplicatePolicy : uint8
+	{
+		First,
+		Last
+	};
+
+	/** Result of joining a target key column against a source key column. */
+	struct FJoinResult
+	{
+		/** For each target element, the index of the matching source element, or INDEX_NONE if there is none. */
+		TArray<int32> TargetToSource;
+
+		int32 NumMatched = 0;
+		int32 NumUnmatched = 0;
+
+		void UpdateCounts()
+		{
+			NumMatched = 0;
+			for (const int32 SourceIdx : TargetToSource)
+			{
+				NumMatched += (SourceIdx != INDEX_NONE) ? 1 : 0;
+			}
+
+			NumUnmatched = TargetToSource.Num() - NumMatched;
+		}
+	};
+
+	/**
+	 * Hash index over a column of keys, mapping each distinct key to every index it appears at.
+	 * Duplicates are chained in insertion order, so the first index added for a key is the first one found.
+	 * Elements can be added in any number of steps, as long as the indices are within the size given to Reset.
+	 */
+	template <typename KeyType>
+	class TJoinIndex
+	{
+		static_assert(TIsJoinKey_V<KeyType>, "KeyType must be hashable.");
+
+	public:
+		TJoinIndex() = default;
+		TJoinIndex(const TJoinIndex&) = delete;
+		TJoinIndex& operator=(const TJoinIndex&) = delete;
+
+		~TJoinIndex()
+		{
+			TScratchPool<int32>::Release(MoveTemp(Next));
+		}
+
+		void Reset(int32 InNum)
+		{
+			Chains.Reset();
+			Chains.Reserve(InNum);
+
+			TScratchPool<int32>::Release(MoveTemp(Next));
+			Next = TScratchPool<int32>::Acquire(InNum);
+		}
+
+		void Add(const KeyType& InKey, int32 InIndex)
+		{
+			Next[InIndex] = INDEX_NONE;
+
+			FChain& Chain = Chains.FindOrAdd(InKey);
+			if (Chain.Last == INDEX_NONE)
+			{
+				Chain.First = InIndex;
+			}
+			else
+			{
+				Next[Chain.Last] = InIndex;
+			}
+
+			Chain.Last = InIndex;
+		}
+
+		void Add(TArrayView<const KeyType> InKeys, int32 InStartIndex)
+		{
+			for (int32 Idx = 0; Idx < InKeys.Num(); ++Idx)
+			{
+				Add(InKeys[Idx], InStartIndex + Idx);
+			}
+		}
+
+		void Build(TArrayView<const KeyType> InKeys)
+		{
+			TRACE_CPUPROFILER_EVENT_SCOPE(UE::PCGPlus::TJoinIndex::Build);
+			Reset(InKeys.Num());
+			Add(InKeys, 0);
+		}
+
+		/** Returns the first index added for this key, or INDEX_NONE. */
+		int32 FindFirst(const KeyType& InKey) const
+		{
+			const FChain* Chain = Chains.Find(InKey);
+			return Chain ? Chain->First : INDEX_NONE;
+		}
+
+		/** Same as FindFirst, but removes the key from the index, so later lookups of it will fail. */
+		int32 FindAndRemoveFirst(const KeyType& InKey)
+		{
+			FChain Chain;
+			return Chains.RemoveAndCopyValue(InKey, Chain) ? Chain.First : INDEX_NONE;
+		}
+
+		/** Returns the last index added for this key, or INDEX_NONE. */
+		int32 FindLast(const KeyType& InKey) const
+		{
+			const FChain* Chain = Chains.Find(InKey);
+			return Chain ? Chain->Last : INDEX_NONE;
+		}
+
+		/** Returns the next index sharing the key of InIndex, or INDEX_NONE at the end of the chain. */
+		int32 GetNext(int32 InIndex) const
+		{
+			return Next[InIndex];
+		}
+
+		/** For each target in [InStartIndex, InEndIndex), stores the first or last indexed source element with the same key. The index must be built over the source keys. */
+		void Probe(TArrayView<const KeyType> InTargetKeys, int32 InStartIndex, int32 InEndIndex, TArrayView<int32> OutTargetToSource, EJoinDuplicatePolicy InPolicy = EJoinDuplicatePolicy::First) const
+		{
+			if (InPolicy == EJoinDuplicatePolicy::First)
+			{
+				for (int32 TargetIdx = InStartIndex; TargetIdx < InEndIndex; ++TargetIdx)
+				{
+					OutTargetToSource[TargetIdx] = FindFirst(InTargetKeys[TargetIdx]);
+				}
+			}
+			else
+			{
+				for (int32 TargetIdx = InStartIndex; TargetIdx < InEndIndex; ++TargetIdx)
+				{
+					OutTargetToSource[TargetIdx] = FindLast(InTargetKeys[TargetIdx]);
+				}
+			}
+		}
+
+		/**
+		 * For each source in [InStartIndex, InEndIndex), assigns it to every indexed target with the same key. The index must be built over the target keys.
+		 * Each key is consumed by the first source element scattered with it. Sources are walked forward for the First policy and backward for Last,
+		 * so over several calls, ranges must be scattered from the start for First and from the end for Last.
+		 */
+		void Scatter(TArrayView<const KeyType> InSourceKeys, int32 InStartIndex, int32 InEndIndex, TArrayView<int32> OutTargetToSource, EJoinDuplicatePolicy InPolicy = EJoinDuplicatePolicy::First)
+		{
+			const bool bForward = InPolicy == EJoinDuplicatePolicy::First;
+			for (int32 Step = 0; Step < InEndIndex - InStartIndex; ++Step)
+			{
+				const int32 SourceIdx = bForward ? InStartIndex + Step : InEndIndex - 1 - Step;
+				for (int32 TargetIdx = FindAndRemoveFirst(InSourceKeys[SourceIdx]); TargetIdx != INDEX_NONE; TargetIdx = GetNext(TargetIdx))
+				{
+					OutTargetToSource[TargetIdx] = SourceIdx;
+				}
+			}
+		}
+
+		int32 GetNumUniqueKeys() const
+		{
+			return Chains.Num();
+		}
+
+		int64 GetAllocatedSize() const
+		{
+			return Chains.GetAllocatedSize() + Next.GetAllocatedSize();
+		}
+
+	private:
+		struct FChain
+		{
+			int32 First = INDEX_NONE;
+			int32 Last = INDEX_NONE;
+		};
+
+		TMap<KeyType, FChain> Chains;
+		TArray<int32> Next;
+	};
+
+	/**
+	 * Matches every target key against the source keys, using a hash index built over the smaller of the two columns.
+	 * When a key appears several times in the source, the policy picks which source element wins.
+	 */
+	template <typename KeyType>
+	FJoinResult HashJoin(TArrayView<const KeyType> InSourceKeys, TArrayView<const KeyType> InTargetKeys, EJoinDuplicatePolicy InPolicy = EJoinDuplicatePolicy::First)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(UE::PCGPlus::HashJoin);
+
+		FJoinResult Result;
+		Result.TargetToSource.Init(INDEX_NONE, InTargetKeys.Num());
+
+		TJoinIndex<KeyType> Index;
+
+		if (InSourceKeys.Num() <= InTargetKeys.Num())
+		{
+			Index.Build(InSourceKeys);
+			Index.Probe(InTargetKeys, 0, InTargetKeys.Num(), Result.TargetToSource, InPolicy);
+		}
+		else
+		{
+			Index.Build(InTargetKeys);
+			Index.Scatter(InSourceKeys, 0, InSourceKeys.Num(), Result.TargetToSource, InPolicy);
+		}
+
+		Result.UpdateCounts();
+
+		return Result;
+	}
+
+	/**
+	 * Same contract as HashJoin, for integer keys: both sides are radix sorted, then merged in a single linear sweep.
+	 * The sort is stable, so the source elements of each key stay in order and the policy can still pick the first or the last one.
+	 */
+	template <typename KeyType>
+	FJoinResult RadixJoin(TArrayView<const KeyType> InSourceKeys, TArrayView<const KeyType> InTargetKeys, EJoinDuplicatePolicy InPolicy = EJoinDuplicatePolicy::First)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(UE::PCGPlus::RadixJoin);
+
+		FJoinResult Result;
+		Result.TargetToSource.Init(INDEX_NONE, InTargetKeys.Num());
+
+		using FPairPool = TScratchPool<TKeyIndexPair<KeyType>>;
+		TArray<TKeyIndexPair<KeyType>> SortedSource = FPairPool::Acquire(InSourceKeys.Num());
+		TArray<TKeyIndexPair<KeyType>> SortedTarget = FPairPool::Acquire(InTargetKeys.Num());
+		TArray<TKeyIndexPair<KeyType>> Scratch = FPairPool::Acquire(FMath::Max(InSourceKeys.Num(), InTargetKeys.Num()));
+
+		RadixArgSort(InSourceKeys, SortedSource, Scratch);
+		RadixArgSort(InTargetKeys, SortedTarget, Scratch);
+
+		int32 SourcePairIdx = 0;
+		for (const TKeyIndexPair<KeyType>& TargetPair : SortedTarget)
+		{
+			while (SourcePairIdx < SortedSource.Num() && SortedSource[SourcePairIdx].Key < TargetPair.Key)
+			{
+				++SourcePairIdx;
+			}
+
+			if (SourcePairIdx == SortedSource.Num())
+			{
+				break;
+			}
+
+			if (SortedSource[SourcePairIdx].Key == TargetPair.Key)
+			{
+				// Skipping to the end of the run is done once per key, as the next targets with this key find the cursor already there
+				while (InPolicy == EJoinDuplicatePolicy::Last && SourcePairIdx + 1 < SortedSource.Num() && SortedSource[SourcePairIdx + 1].Key == TargetPair.Key)
+				{
+					++SourcePairIdx;
+				}
+
+				Result.TargetToSource[TargetPair.Index] = SortedSource[SourcePairIdx].Index;
+				++Result.NumMatched;
+			}
+		}
+
+		Result.NumUnmatched = InTargetKeys.Num() - Result.NumMatched;
+
+		FPairPool::Release(MoveTemp(SortedSource));
+		FPairPool::Release(MoveTemp(SortedTarget));
+		FPairPool::Release(MoveTemp(Scratch));
+
+		return Result;
+	}
+
+	/**
+	 * Joins with the fastest backend for this key type and input size.
+	 * Sorting only pays off when both sides are large. A small lookup table against a large target is hashed, and the target is streamed through it.
+	 */
+	template <typename KeyType>
+	FJoinResult Join(TArrayView<const KeyType> InSourceKeys, TArrayView<const KeyType> InTargetKeys, EJoinDuplicatePolicy InPolicy = EJoinDuplicatePolicy::First)
+	{
+		if constexpr (TIsRadixSortable_V<KeyType>)
+		{
+			if (FMath::Min(InSourceKeys.Num(), InTargetKeys.Num()) >= RadixJoinThreshold)
+			{
+				return RadixJoin(InSourceKeys, InTargetKeys, InPolicy);
+			}
+		}
+
+		return HashJoin(InSourceKeys, InTargetKeys, InPolicy);
+	}
+
+	/** Join that can be advanced a slice at a time, so it can be spread over several executions. */
+	class IJoinTask
+	{
+	public:
+		virtual ~IJoinTask() = default;
+
+		/** Advances the join by about InNumElements elements. Returns true once the result is complete. */
+		virtual bool Step(int32 InNumElements) = 0;
+
+		virtual const FJoinResult& GetResult() const = 0;
+
+		/** Moves the result out of a completed task. */
+		virtual FJoinResult TakeResult() = 0;
+	};
+
+	/**
+	 * Resumable version of Join, owning its key columns and its partially built index. The key columns are given back to the scratch pool once the task is destroyed.
+	 * The hash backend builds then probes in slices. The radix backend is not resumable mid-pass, so it completes within the first step.
+	 */
+	template <typename KeyType>
+	class TJoinTask final : public IJoinTask
+	{
+	public:
+		TJoinTask(TArray<KeyType>&& InSourceKeys, TArray<KeyType>&& InTargetKeys, EJoinDuplicatePolicy InPolicy = EJoinDuplicatePolicy::First)
+			: SourceKeys(MoveTemp(InSourceKeys))
+			, TargetKeys(MoveTemp(InTargetKeys))
+			, bIndexSource(SourceKeys.Num() <= TargetKeys.Num())
+			, Policy(InPolicy)
+		{
+		}
+
+		/** Only probes an index built beforehand over the source keys, which can be shared by the tasks of many targets. */
+		TJoinTask(TSharedPtr<const TJoinIndex<KeyType>> InSourceIndex, TArray<KeyType>&& InTargetKeys, EJoinDuplicatePolicy InPolicy = EJoinDuplicatePolicy::First)
+			: TargetKeys(MoveTemp(InTargetKeys))
+			, bIndexSource(true)
+			, Policy(InPolicy)
+			, SharedSourceIndex(MoveTemp(InSourceIndex))
+		{
+			check(SharedSourceIndex.IsValid());
+		}
+
+		virtual ~TJoinTask() override
+		{
+			if constexpr (std::is_trivially_copyable_v<KeyType>)
+			{
+				TScratchPool<KeyType>::Release(MoveTemp(SourceKeys));
+				TScratchPool<KeyType>::Release(MoveTemp(TargetKeys));
+			}
+		}
+
+		virtual bool Step(int32 InNumElements) override
+		{
+			TRACE_CPUPROFILER_EVENT_SCOPE(UE::PCGPlus::TJoinTask::Step);
+
+			if (Stage == EStage::Start)
+			{
+				Result.TargetToSource.Init(INDEX_NONE, TargetKeys.Num());
+
+				if (SharedSourceIndex.IsValid())
+				{
+					Stage = EStage::Match;
+				}
+				else
+				{
+					if constexpr (TIsRadixSortable_V<KeyType>)
+					{
+						if (FMath::Min(SourceKeys.Num(), TargetKeys.Num()) >= RadixJoinThreshold)
+						{
+							Result = RadixJoin<KeyType>(SourceKeys, TargetKeys, Policy);
+							Stage = EStage::Done;
+							return true;
+						}
+					}
+
+					Index.Reset(bIndexSource ? SourceKeys.Num() : TargetKeys.Num());
+					Stage = EStage::Build;
+				}
+			}
+
+			while (Stage != EStage::Done && InNumElements > 0)
+			{
+				if (Stage == EStage::Build)
+				{
+					const TArray<KeyType>& IndexedKeys = bIndexSource ? SourceKeys : TargetKeys;
+					const int32 Count = FMath::Min(InNumElements, IndexedKeys.Num() - Cursor);
+
+					Index.Add(TArrayView<const KeyType>(IndexedKeys).Slice(Cursor, Count), Cursor);
+					Cursor += Count;
+					InNumElements -= Count;
+
+					if (Cursor == IndexedKeys.Num())
+					{
+						Stage = EStage::Match;
+						Cursor = 0;
+					}
+				}
+				else
+				{
+					const TArray<KeyType>& MatchedKeys = bIndexSource ? TargetKeys : SourceKeys;
+					const int32 EndIndex = FMath::Min(Cursor + InNumElements, MatchedKeys.Num());
+
+					if (bIndexSource)
+					{
+						const TJoinIndex<KeyType>& SourceIndex = SharedSourceIndex.IsValid() ? *SharedSourceIndex : Index;
+						SourceIndex.Probe(MatchedKeys, Cursor, EndIndex, Result.TargetToSource, Policy);
+					}
+					else if (Policy == EJoinDuplicatePolicy::First)
+					{
+						Index.Scatter(MatchedKeys, Cursor, EndIndex, Result.TargetToSource, Policy);
+					}
+					else
+					{
+						// Sources are scattered from the end for the last one to win
+						Index.Scatter(MatchedKeys, MatchedKeys.Num() - EndIndex, MatchedKeys.Num() - Cursor, Result.TargetToSource, Policy);
+					}
+
+					InNumElements -= EndIndex - Cursor;
+					Cursor = EndIndex;
+
+					if (Cursor == MatchedKeys.Num())
+					{
+						Result.UpdateCounts();
+						Stage = EStage::Done;
+					}
+				}
+			}
+
+			return Stage == EStage::Done;
+		}
+
+		virtual const FJoinResult& GetResult() const override
+		{
+			return Result;
+		}
+
+		virtual FJoinResult TakeResult() override
+		{
+			check(Stage == EStage::Done);
+			return MoveTemp(Result);
+		}
+
+	private:
+		enum class EStage : uint8
+		{
+			Start,
+			Build,
+			Match,
+			Done
+		};
+
+		TArray<KeyType> SourceKeys;
+		TArray<KeyType> TargetKeys;
+		const bool bIndexSource;
+		const EJoinDuplicatePolicy Policy;
+
+		TSharedPtr<const TJoinIndex<KeyType>> SharedSourceIndex;
+		TJoinIndex<KeyType> Index;
+		FJoinResult Result;
+		EStage Stage = EStage::Start;
+		int32 Cursor = 0;
+	};
+
+	/**
+	 * Matches each target to the source returned by a query, in slices of parallel queries.
+	 * The query maps a target to a source index or INDEX_NONE. It runs on worker threads, so whatever it reads must not change while the task lives.
+	 */
+	template <typename TargetType, typename QueryType>
+	class TParallelProbeJoinTask final : public IJoinTask
+	{
+	public:
+		TParallelProbeJoinTask(TArray<TargetType>&& InTargets, QueryType InQuery)
+			: Targets(MoveTemp(InTargets))
+			, Query(MoveTemp(InQuery))
+		{
+			Result.TargetToSource.SetNumUninitialized(Targets.Num());
+		}
+
+		virtual bool Step(int32 InNumElements) override
+		{
+			TRACE_CPUPROFILER_EVENT_SCOPE(UE::PCGPlus::TParallelProbeJoinTask::Step);
+
+			const int32 StartIndex = Cursor;
+			const int32 EndIndex = FMath::Min(Cursor + FMath::Max(InNumElements, 1), Targets.Num());
+			const int32 NumTasks = FMath::DivideAndRoundUp(EndIndex - StartIndex, QueriesPerTask);
+
+			ParallelFor(NumTasks, [this, StartIndex, EndIndex](int32 TaskIndex)
+			{
+				const int32 TaskStart = StartIndex + TaskIndex * QueriesPerTask;
+				const int32 TaskEnd = FMath::Min(TaskStart + QueriesPerTask, EndIndex);
+
+				for (int32 TargetIdx = TaskStart; TargetIdx < TaskEnd; ++TargetIdx)
+				{
+					Result.TargetToSource[TargetIdx] = Query(Targets[TargetIdx]);
+				}
+			});
+
+			Cursor = EndIndex;
+
+			if (Cursor == Targets.Num() && !bDone)
+			{
+				Result.UpdateCounts();
+				bDone = true;
+			}
+
+			return bDone;
+		}
+
+		virtual const FJoinResult& GetResult() const override
+		{
+			return Result;
+		}
+
+		virtual FJoinResult TakeResult() override
+		{
+			check(bDone);
+			return MoveTemp(Result);
+		}
+
+	private:
+		/** Number of queries run by each parallel task. */
+		static constexpr int32 QueriesPerTask = 1024;
+
+		TArray<TargetType> Targets;
+		QueryType Query;
+
+		FJoinResult Result;
+		int32 Cursor = 0;
+		bool bDone = false;
+	};
+
+	template <typename TargetType, typename QueryType>
+	TUniquePtr<IJoinTask> MakeParallelProbeJoinTask(TArray<TargetType>&& InTargets, QueryType&& InQuery)
+	{
+		return MakeUnique<TParallelProbeJoinTask<TargetType, std::decay_t<QueryType>>>(MoveTemp(InTargets), Forward<QueryType>(InQuery));
+	}
+}
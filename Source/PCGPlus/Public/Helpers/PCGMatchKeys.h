@@ -0,0 +1,103 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Helpers/PCGJoinIndex.h"
+#include "Metadata/PCGAttributePropertySelector.h"
+
+struct FPCGContext;
+class UPCGData;
+
+namespace UE::PCGPlus
+{
+	/** Typed copy of one key column, kept to check that elements matched through their fingerprints really have equal keys. */
+	class IMatchKeyColumn
+	{
+	public:
+		virtual ~IMatchKeyColumn() = default;
+
+		/** The other column must have the same type, which is the case for the columns of keys read against each other. */
+		virtual bool Equals(int32 InIndex, const IMatchKeyColumn& InOther, int32 InOtherIndex) const = 0;
+
+		virtual FString ToString(int32 InIndex) const = 0;
+	};
+
+	/**
+	 * Match keys of one side of a join, read from one or more attributes/properties.
+	 * Each element is hashed once into a 64-bit fingerprint, and those are what gets joined, so keys of any type join as fast as integers.
+	 */
+	struct PCGPLUS_API FMatchKeys
+	{
+		FMatchKeys() = default;
+		FMatchKeys(FMatchKeys&&) = default;
+		FMatchKeys& operator=(FMatchKeys&&) = default;
+		~FMatchKeys();
+
+		/** Taken from the scratch pool of uint64, so should be given back to it when moved out. */
+		TArray<uint64> Fingerprints;
+
+		/** Metadata type each column was read as. */
+		TArray<uint16> Types;
+
+		/** Key values, kept when different keys can share a fingerprint or when asked for. Single integer, boolean or name keys are their own fingerprint. */
+		TArray<TUniquePtr<IMatchKeyColumn>> Columns;
+
+		/** Whether the keys are their own fingerprint, even though their values were kept. */
+		bool bExact = false;
+
+		/** Whether equal fingerprints always mean equal keys. */
+		bool IsExact() const { return bExact || Columns.IsEmpty(); }
+
+		int32 Num() const { return Fingerprints.Num(); }
+
+		/** Compares the actual keys of two elements. Both keys must have been read in the same types. */
+		bool Equals(int32 InIndex, const FMatchKeys& InOther, int32 InOtherIndex) const;
+
+		/** Key of an element as text, its columns separated by commas. Separators in the values are escaped. Only valid when the key values were kept. */
+		FString ToString(int32 InIndex) const;
+
+		/**
+		 * Reads and fingerprints the keys of InData. With InTypesFrom, each column is read in the type of the same column of those keys,
+		 * which is how the target side of a join is read against the source side. Logs and returns false on failure.
+		 * With bInKeepValues, the key values are kept even when the fingerprints are exact, so they can be turned into text.
+		 */
+		bool Read(FPCGContext* Context, const UPCGData* InData, TArrayView<const FPCGAttributePropertyInputSelector> InSelectors, const FMatchKeys* InTypesFrom = nullptr, bool bInKeepValues = false);
+
+		void Reset();
+	};
+
+	/**
+	 * Checks the pairs of a join over fingerprints against the actual keys.
+	 * A target that was matched through a fingerprint collision is matched again by comparing its keys with every source element, following the policy.
+	 * With 64-bit fingerprints that is not expected to ever happen in practice, but the result is exact either way.
+	 */
+	PCGPLUS_API void VerifyMatches(const FMatchKeys& InSourceKeys, const FMatchKeys& InTargetKeys, FJoinResult& InOutResult, EJoinDuplicatePolicy InPolicy = EJoinDuplicatePolicy::First);
+
+	/** Maps each element to the first element with the same keys, by joining the keys against themselves. */
+	PCGPLUS_API void GroupKeys(const FMatchKeys& InKeys, TArray<int32>& OutGroups);
+
+	/** Selectors of keys made of a main attribute/property and additional ones, the main one first. InProjection picks the selector of each additional element. */
+	template <typename AdditionalType, typename ProjectionType>
+	TArray<FPCGAttributePropertyInputSelector> GetKeySelectors(const FPCGAttributePropertyInputSelector& InMain, const TArray<AdditionalType>& InAdditional, ProjectionType&& InProjection)
+	{
+		TArray<FPCGAttributePropertyInputSelector> Selectors;
+		Selectors.Reserve(1 + InAdditional.Num());
+		Selectors.Add(InMain);
+
+		for (const AdditionalType& Additional : InAdditional)
+		{
+			Selectors.Add(Invoke(InProjection, Additional));
+		}
+
+		return Selectors;
+	}
+
+	inline TArray<FPCGAttributePropertyInputSelector> GetKeySelectors(const FPCGAttributePropertyInputSelector& InMain, const TArray<FPCGAttributePropertyInputSelector>& InAdditional)
+	{
+		return GetKeySelectors(InMain, InAdditional, [](const FPCGAttributePropertyInputSelector& InSelector) -> const FPCGAttributePropertyInputSelector& { return InSelector; });
+	}
+
+	/** Names of the attributes/properties of keys, as read from InData, separated by commas. */
+	PCGPLUS_API FString GetKeySelectorsString(const UPCGData* InData, TArrayView<const FPCGAttributePropertyInputSelector> InSelectors);
+}
@@ -0,0 +1,41 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Helpers/PCGJoinIndex.h"
+
+namespace UE::PCGPlus
+{
+	/**
+	 * Static KD-tree over a set of positions, answering nearest neighbour queries.
+	 * Nodes are implicit: each range of the position array is split at its middle element, along the widest axis of the range.
+	 */
+	class PCGPLUS_API FKdTree
+	{
+	public:
+		void Build(TArrayView<const FVector> InPositions);
+
+		/** Returns the index of the position nearest to InQuery, within InMaxDistanceSquared, or INDEX_NONE. Ties go to the lowest index. */
+		int32 FindNearest(const FVector& InQuery, double InMaxDistanceSquared = TNumericLimits<double>::Max()) const;
+
+		int32 Num() const { return Positions.Num(); }
+
+	private:
+		void BuildRange(int32 InBegin, int32 InEnd);
+		void SearchRange(int32 InBegin, int32 InEnd, const FVector& InQuery, double& InOutBestDistanceSquared, int32& InOutBestIndex) const;
+
+		/** Below this many positions, a range is scanned instead of split. */
+		static constexpr int32 LeafSize = 8;
+
+		/** Positions in tree order, with the index each one had in the input. */
+		TArray<FVector> Positions;
+		TArray<int32> Indices;
+
+		/** Split axis of the node at the middle of each range. */
+		TArray<uint8> Axes;
+	};
+
+	/** Matches each target position to the nearest source position of a tree. The tree can be shared by the tasks of many targets. A negative max distance means unlimited. */
+	PCGPLUS_API TUniquePtr<IJoinTask> MakeNearestJoinTask(TSharedPtr<const FKdTree> InSourceTree, TArray<FVector>&& InTargetPositions, double InMaxDistance);
+}
@@ -0,0 +1,106 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+#include <type_traits>
+
+namespace UE::PCGPlus
+{
+	/**
+	 * Whether keys of this type can be sorted with RadixSort. Enums are stored as int64 in metadata, so they are covered too.
+	 * Unsigned 64-bit keys are the fingerprints of match keys of any other type.
+	 */
+	template <typename KeyType>
+	inline constexpr bool TIsRadixSortable_V = std::is_same_v<KeyType, int32> || std::is_same_v<KeyType, int64> || std::is_same_v<KeyType, uint64>;
+
+	/** Key with the index of the element it was read from, as the payload carried through the sort. */
+	template <typename KeyType>
+	struct TKeyIndexPair
+	{
+		KeyType Key;
+		int32 Index;
+	};
+
+	/**
+	 * Stable LSD radix sort of key/index pairs, one byte per pass.
+	 * Passes where every key has the same byte are skipped, so narrow key ranges only cost a couple of passes.
+	 * InOutScratch is resized as needed and can be kept across calls to avoid reallocating.
+	 */
+	template <typename KeyType>
+	void RadixSort(TArray<TKeyIndexPair<KeyType>>& InOutPairs, TArray<TKeyIndexPair<KeyType>>& InOutScratch)
+	{
+		static_assert(TIsRadixSortable_V<KeyType>, "KeyType must be int32, int64 or uint64.");
+		TRACE_CPUPROFILER_EVENT_SCOPE(UE::PCGPlus::RadixSort);
+
+		using UnsignedType = std::make_unsigned_t<KeyType>;
+		constexpr int32 NumPasses = sizeof(KeyType);
+		constexpr int32 NumBuckets = 256;
+		// Flipping the sign bit makes signed keys sort correctly as unsigned.
+		constexpr UnsignedType SignBit = std::is_signed_v<KeyType> ? UnsignedType(1) << (sizeof(KeyType) * 8 - 1) : UnsignedType(0);
+
+		const int32 Num = InOutPairs.Num();
+		if (Num < 2)
+		{
+			return;
+		}
+
+		auto GetDigit = [](KeyType InKey, int32 InPass) -> int32
+		{
+			return static_cast<int32>(((static_cast<UnsignedType>(InKey) ^ SignBit) >> (InPass * 8)) & 0xFF);
+		};
+
+		// All histograms are built in a single read of the keys.
+		int32 Histograms[NumPasses][NumBuckets] = {};
+		for (const TKeyIndexPair<KeyType>& Pair : InOutPairs)
+		{
+			for (int32 Pass = 0; Pass < NumPasses; ++Pass)
+			{
+				++Histograms[Pass][GetDigit(Pair.Key, Pass)];
+			}
+		}
+
+		InOutScratch.SetNumUninitialized(Num);
+
+		for (int32 Pass = 0; Pass < NumPasses; ++Pass)
+		{
+			int32* Histogram = Histograms[Pass];
+			if (Histogram[GetDigit(InOutPairs[0].Key, Pass)] == Num)
+			{
+				continue;
+			}
+
+			int32 Offset = 0;
+			for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+			{
+				const int32 Count = Histogram[Bucket];
+				Histogram[Bucket] = Offset;
+				Offset += Count;
+			}
+
+			const TKeyIndexPair<KeyType>* Src = InOutPairs.GetData();
+			TKeyIndexPair<KeyType>* Dst = InOutScratch.GetData();
+			for (int32 Idx = 0; Idx < Num; ++Idx)
+			{
+				Dst[Histogram[GetDigit(Src[Idx].Key, Pass)]++] = Src[Idx];
+			}
+
+			Swap(InOutPairs, InOutScratch);
+		}
+	}
+
+	/** Builds the key/index pairs for a key column and radix sorts them. */
+	template <typename KeyType>
+	void RadixArgSort(TArrayView<const KeyType> InKeys, TArray<TKeyIndexPair<KeyType>>& OutPairs, TArray<TKeyIndexPair<KeyType>>& InOutScratch)
+	{
+		OutPairs.SetNumUninitialized(InKeys.Num());
+		for (int32 Idx = 0; Idx < InKeys.Num(); ++Idx)
+		{
+			OutPairs[Idx] = { InKeys[Idx], Idx };
+		}
+
+		RadixSort(OutPairs, InOutScratch);
+	}
+}
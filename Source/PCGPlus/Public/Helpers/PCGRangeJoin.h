@@ -0,0 +1,41 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Helpers/PCGJoinIndex.h"
+
+namespace UE::PCGPlus
+{
+	/**
+	 * Static index over a set of ranges, finding the ranges containing a value.
+	 * Ranges are sorted by their min and form an implicit interval tree: each range of the array is split at its middle element, which keeps the highest max of the range.
+	 * A query skips the subtrees whose highest max is below the value and the ranges starting after it, so it visits O(log N) nodes plus the ranges it finds.
+	 */
+	class PCGPLUS_API FRangeIndex
+	{
+	public:
+		/** Ranges are inclusive at both ends. Ranges with a NaN bound, or with a max below their min, never contain anything. */
+		void Build(TArrayView<const double> InMins, TArrayView<const double> InMaxs);
+
+		/** Returns the index of the range containing InValue, or INDEX_NONE. When several ranges contain it, the policy picks the lowest or the highest index. */
+		int32 Find(double InValue, EJoinDuplicatePolicy InPolicy = EJoinDuplicatePolicy::First) const;
+
+		int32 Num() const { return Mins.Num(); }
+
+	private:
+		double BuildRange(int32 InBegin, int32 InEnd);
+		void SearchRange(int32 InBegin, int32 InEnd, double InValue, EJoinDuplicatePolicy InPolicy, int32& InOutBestIndex) const;
+
+		/** Ranges in order of their min, with the index each one had in the input. */
+		TArray<double> Mins;
+		TArray<double> Maxs;
+		TArray<int32> Indices;
+
+		/** Highest max over the ranges of the subtree at the middle of each range. */
+		TArray<double> SubtreeMaxs;
+	};
+
+	/** Matches each target value to the source range containing it. The index can be shared by the tasks of many targets. */
+	PCGPLUS_API TUniquePtr<IJoinTask> MakeRangeJoinTask(TSharedPtr<const FRangeIndex> InSourceIndex, TArray<double>&& InTargetValues, EJoinDuplicatePolicy InPolicy);
+}
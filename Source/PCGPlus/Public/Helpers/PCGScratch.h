@@ -0,0 +1,173 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <type_traits>
+
+namespace UE::PCGPlus
+{
+	/** Counters of the scratch pools, over all threads and element types. */
+	struct FScratchStats
+	{
+		/** Buffers that had to be allocated or grown, because no pooled buffer was large enough. */
+		int64 NumAllocations = 0;
+
+		/** Buffers served from a pool without allocating. */
+		int64 NumReuses = 0;
+
+		int64 BytesInUse = 0;
+		int64 PeakBytesInUse = 0;
+
+		/** Bytes held by the pools, released and waiting to be reused. */
+		int64 BytesPooled = 0;
+	};
+
+	namespace Scratch
+	{
+		/** Most bytes kept pooled over all threads and element types. Set by pcgplus.Scratch.MaxPooledMB. */
+		PCGPLUS_API int64 GetMaxPooledBytes();
+
+		PCGPLUS_API void NotifyAcquired(int64 InBytes, bool bInAllocated);
+		PCGPLUS_API void NotifyReleased(int64 InBytes);
+
+		/** Counts an array of InBytes into the pools, unless it would go over the budget. */
+		PCGPLUS_API bool TryPool(int64 InBytes);
+		PCGPLUS_API void NotifyUnpooled(int64 InBytes);
+
+		/** Changed by Trim. A pool frees its arrays the next time it is used after a change. */
+		PCGPLUS_API uint32 GetGeneration();
+
+		/** Frees the arrays pooled by every thread, each the next time its pool is used. */
+		PCGPLUS_API void Trim();
+
+		PCGPLUS_API FScratchStats GetStats();
+
+		/** Restarts the peak from the bytes currently in use. */
+		PCGPLUS_API void ResetPeak();
+	}
+
+	/**
+	 * Per thread pool of arrays for the temporaries of an execution, so that many small executions reuse the same allocations.
+	 * Arrays are acquired sized and uninitialized, and should be released once done with. They can be released from any thread,
+	 * and then go to the pool of that thread. The pools of all threads share a single budget, and are freed when their thread exits.
+	 */
+	template <typename T>
+	class TScratchPool
+	{
+		static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>, "Only trivial types can be pooled uninitialized.");
+
+		static constexpr int32 MaxPooledArrays = 8;
+
+	public:
+		static TArray<T> Acquire(int32 InNum)
+		{
+			TArray<TArray<T>>& Pool = GetThreadPool();
+
+			// The smallest array that fits, or else the largest one, which will be grown
+			int32 BestIdx = INDEX_NONE;
+			for (int32 Idx = 0; Idx < Pool.Num(); ++Idx)
+			{
+				const int32 Max = Pool[Idx].Max();
+				if (BestIdx == INDEX_NONE)
+				{
+					BestIdx = Idx;
+					continue;
+				}
+
+				const int32 BestMax = Pool[BestIdx].Max();
+				const bool bFits = Max >= InNum;
+				const bool bBestFits = BestMax >= InNum;
+				if ((bFits && (!bBestFits || Max < BestMax)) || (!bFits && !bBestFits && Max > BestMax))
+				{
+					BestIdx = Idx;
+				}
+			}
+
+			TArray<T> Array;
+			if (BestIdx != INDEX_NONE)
+			{
+				Array = MoveTemp(Pool[BestIdx]);
+				Pool.RemoveAtSwap(BestIdx, 1, EAllowShrinking::No);
+				Scratch::NotifyUnpooled(Array.GetAllocatedSize());
+			}
+
+			const bool bAllocated = Array.Max() < InNum;
+			Array.SetNumUninitialized(InNum, EAllowShrinking::No);
+
+			Scratch::NotifyAcquired(Array.GetAllocatedSize(), bAllocated);
+
+			return Array;
+		}
+
+		static TArray<T> AcquireCopy(TArrayView<const T> InValues)
+		{
+			TArray<T> Array = Acquire(InValues.Num());
+			if (InValues.Num() > 0)
+			{
+				FMemory::Memcpy(Array.GetData(), InValues.GetData(), InValues.Num() * sizeof(T));
+			}
+
+			return Array;
+		}
+
+		static void Release(TArray<T>&& InArray)
+		{
+			const int64 Bytes = InArray.GetAllocatedSize();
+			if (Bytes == 0)
+			{
+				return;
+			}
+
+			Scratch::NotifyReleased(Bytes);
+
+			TArray<TArray<T>>& Pool = GetThreadPool();
+			if (Pool.Num() < MaxPooledArrays && Scratch::TryPool(Bytes))
+			{
+				InArray.Reset();
+				Pool.Add(MoveTemp(InArray));
+			}
+			else
+			{
+				InArray.Empty();
+			}
+		}
+
+	private:
+		struct FThreadPool
+		{
+			TArray<TArray<T>> Arrays;
+			uint32 Generation = 0;
+
+			~FThreadPool()
+			{
+				Empty();
+			}
+
+			void Empty()
+			{
+				for (const TArray<T>& Array : Arrays)
+				{
+					Scratch::NotifyUnpooled(Array.GetAllocatedSize());
+				}
+
+				Arrays.Empty();
+			}
+		};
+
+		static TArray<TArray<T>>& GetThreadPool()
+		{
+			thread_local FThreadPool Pool;
+
+			const uint32 Generation = Scratch::GetGeneration();
+			if (Pool.Generation != Generation)
+			{
+				Pool.Empty();
+				Pool.Generation = Generation;
+			}
+
+			return Pool.Arrays;
+		}
+	};
+}
@@ -0,0 +1,760 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PCGPlusBenchmarkCommandlet.h"
+
+#include "Data/PCGPointData.h"
+#include "Dom/JsonObject.h"
+#include "Elements/PCGCopyAttributeElement.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Helpers/PCGScratch.h"
+#include "Math/RandomStream.h"
+#include "Metadata/PCGMetadata.h"
+#include "Metadata/PCGMetadataAttributeTpl.h"
+#include "Misc/App.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "PCGContext.h"
+#include "PCGElement.h"
+#include "PCGPoint.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/UObjectGlobals.h"
+
+#include <type_traits>
+
+DEFINE_LOG_CATEGORY_STATIC(LogPCGPlusBenchmark, Log, All);
+
+namespace UE::PCGPlus::Benchmark
+{
+	enum class ECase : uint8
+	{
+		AttributeToAttribute,
+		PropertyToAttribute,
+		MatchSorted,
+		MatchShuffled,
+		MatchSparse,
+		MismatchedTypes,
+		AggregateSum,
+		MatchNearest,
+		MatchRange,
+		MatchSample,
+		DeduplicateValues,
+		InnerJoin,
+		MoveRename,
+		MoveAlias,
+		Count
+	};
+
+	const TCHAR* GetCaseName(ECase InCase)
+	{
+		switch (InCase)
+		{
+		case ECase::AttributeToAttribute:
+			return TEXT("AttributeToAttribute");
+		case ECase::PropertyToAttribute:
+			return TEXT("PropertyToAttribute");
+		case ECase::MatchSorted:
+			return TEXT("MatchSorted");
+		case ECase::MatchShuffled:
+			return TEXT("MatchShuffled");
+		case ECase::MatchSparse:
+			return TEXT("MatchSparse");
+		case ECase::MismatchedTypes:
+			return TEXT("MismatchedTypes");
+		case ECase::AggregateSum:
+			return TEXT("AggregateSum");
+		case ECase::MatchNearest:
+			return TEXT("MatchNearest");
+		case ECase::MatchRange:
+			return TEXT("MatchRange");
+		case ECase::MatchSample:
+			return TEXT("MatchSample");
+		case ECase::DeduplicateValues:
+			return TEXT("DeduplicateValues");
+		case ECase::InnerJoin:
+			return TEXT("InnerJoin");
+		case ECase::MoveRename:
+			return TEXT("MoveRename");
+		case ECase::MoveAlias:
+			return TEXT("MoveAlias");
+		default:
+			return TEXT("Unknown");
+		}
+	}
+
+	/** Cases matching on the Key attribute. */
+	bool IsKeyMatchCase(ECase InCase)
+	{
+		return InCase == ECase::MatchSorted || InCase == ECase::MatchShuffled || InCase == ECase::MatchSparse || InCase == ECase::DeduplicateValues || InCase == ECase::InnerJoin;
+	}
+
+	/** Cases moving an attribute within their single input, which is both the source and the target. */
+	bool IsMoveCase(ECase InCase)
+	{
+		return InCase == ECase::MoveRename || InCase == ECase::MoveAlias;
+	}
+
+	const FName KeyAttribute = TEXT("Key");
+	const FName ValueAttribute = TEXT("Value");
+	const FName CountAttribute = TEXT("Count");
+	const FName CopiedAttribute = TEXT("Copied");
+
+	/** Share of the target keys that exist in the source, for the sparse match. */
+	constexpr float SparseMatchRatio = 0.1f;
+
+	/** Extent of the hard bounds of every point. Points one apart do not overlap, nor touch a point half way between them. */
+	constexpr double PointExtent = 0.2;
+
+	/** Source values are 0.5 apart, so each target value is in two or three source ranges. */
+	constexpr double RangeTolerance = 0.6;
+
+	/** Source values are a function of the point index, so the expected outputs do not need to be stored. Source keys are all even. */
+	int64 GetSourceKey(int32 InIndex) { return static_cast<int64>(InIndex) * 2; }
+	double GetSourceValue(int32 InIndex) { return InIndex * 0.5; }
+	int32 GetSourceCount(int32 InIndex) { return InIndex % 1000; }
+	float GetSourceDensity(int32 InIndex) { return FMath::Frac(InIndex * 0.618f); }
+
+	struct FResult
+	{
+		FString Case;
+		int32 NumPoints = 0;
+		double BestSeconds = 0.0;
+		double PointsPerSecond = 0.0;
+		/** Growth of the used physical memory over the case, sampled at the end of each execution while its output is alive. */
+		int64 UsedPhysicalDelta = 0;
+		/** Peak of the scratch bytes in use over the case, above those in use before it. */
+		int64 PeakScratchBytes = 0;
+		/** Buffers the scratch pools had to allocate or grow. Other allocations are not counted. */
+		int64 ScratchAllocations = 0;
+		bool bCorrect = false;
+	};
+
+	UPCGPointData* MakeSource(int32 InNumPoints)
+	{
+		UPCGPointData* Data = NewObject<UPCGPointData>();
+		TArray<FPCGPoint>& Points = Data->GetMutablePoints();
+		Points.SetNum(InNumPoints);
+
+		FPCGMetadataAttribute<int64>* Keys = Data->Metadata->CreateAttribute<int64>(KeyAttribute, 0, /*bAllowsInterpolation=*/false, /*bOverrideParent=*/false);
+		FPCGMetadataAttribute<double>* Values = Data->Metadata->CreateAttribute<double>(ValueAttribute, 0.0, /*bAllowsInterpolation=*/true, /*bOverrideParent=*/false);
+		FPCGMetadataAttribute<int32>* Counts = Data->Metadata->CreateAttribute<int32>(CountAttribute, 0, /*bAllowsInterpolation=*/true, /*bOverrideParent=*/false);
+
+		for (int32 Idx = 0; Idx < InNumPoints; ++Idx)
+		{
+			FPCGPoint& Point = Points[Idx];
+			Point.Transform.SetLocation(FVector(Idx, 0.0, 0.0));
+			Point.BoundsMin = FVector(-PointExtent);
+			Point.BoundsMax = FVector(PointExtent);
+			Point.Steepness = 1.0f;
+			Point.Density = GetSourceDensity(Idx);
+			Point.Seed = Idx;
+			Point.MetadataEntry = Data->Metadata->AddEntry();
+
+			Keys->SetValue(Point.MetadataEntry, GetSourceKey(Idx));
+			Values->SetValue(Point.MetadataEntry, GetSourceValue(Idx));
+			Counts->SetValue(Point.MetadataEntry, GetSourceCount(Idx));
+		}
+
+		return Data;
+	}
+
+	UPCGPointData* MakeTarget(ECase InCase, int32 InNumPoints, FRandomStream& InStream)
+	{
+		UPCGPointData* Data = NewObject<UPCGPointData>();
+		TArray<FPCGPoint>& Points = Data->GetMutablePoints();
+		Points.SetNum(InNumPoints);
+
+		for (int32 Idx = 0; Idx < InNumPoints; ++Idx)
+		{
+			// Nearest targets are scattered along the sources, a bit past both ends.
+			// Sampled targets alternate between the bounds of a source point, and the gap half way to the next one.
+			double X = Idx;
+			double Y = 1.0;
+			if (InCase == ECase::MatchNearest)
+			{
+				X = InStream.RandRange(-2, InNumPoints) + InStream.FRand();
+			}
+			else if (InCase == ECase::MatchSample)
+			{
+				X = Idx * 0.5;
+				Y = 0.0;
+			}
+
+			FPCGPoint& Point = Points[Idx];
+			Point.Transform.SetLocation(FVector(X, Y, 0.0));
+			Point.BoundsMin = FVector(-PointExtent);
+			Point.BoundsMax = FVector(PointExtent);
+			Point.Steepness = 1.0f;
+			Point.Density = 0.0f;
+			Point.Seed = Idx;
+			Point.MetadataEntry = Data->Metadata->AddEntry();
+		}
+
+		if (InCase == ECase::AggregateSum)
+		{
+			// Same keys as the Count of the sources, so each target sums every source with its key
+			FPCGMetadataAttribute<int32>* Counts = Data->Metadata->CreateAttribute<int32>(CountAttribute, 0, /*bAllowsInterpolation=*/true, /*bOverrideParent=*/false);
+			for (int32 Idx = 0; Idx < InNumPoints; ++Idx)
+			{
+				Counts->SetValue(Points[Idx].MetadataEntry, GetSourceCount(Idx));
+			}
+
+			return Data;
+		}
+
+		if (InCase == ECase::MatchRange)
+		{
+			// Values go a bit past both ends of the source values, so some targets are in no range
+			FPCGMetadataAttribute<double>* Values = Data->Metadata->CreateAttribute<double>(ValueAttribute, 0.0, /*bAllowsInterpolation=*/true, /*bOverrideParent=*/false);
+			for (int32 Idx = 0; Idx < InNumPoints; ++Idx)
+			{
+				Values->SetValue(Points[Idx].MetadataEntry, (InStream.RandRange(-8, InNumPoints * 2 + 4) + InStream.FRand()) * 0.25);
+			}
+
+			return Data;
+		}
+
+		if (!IsKeyMatchCase(InCase))
+		{
+			return Data;
+		}
+
+		TArray<int64> TargetKeys;
+		TargetKeys.SetNumUninitialized(InNumPoints);
+		for (int32 Idx = 0; Idx < InNumPoints; ++Idx)
+		{
+			if (InCase == ECase::MatchSparse || InCase == ECase::InnerJoin)
+			{
+				// Odd keys are never in the source
+				const int64 Key = GetSourceKey(InStream.RandHelper(InNumPoints));
+				TargetKeys[Idx] = InStream.FRand() < SparseMatchRatio ? Key : Key + 1;
+			}
+			else
+			{
+				TargetKeys[Idx] = GetSourceKey(Idx);
+			}
+		}
+
+		if (InCase == ECase::MatchShuffled || InCase == ECase::DeduplicateValues)
+		{
+			for (int32 Idx = InNumPoints - 1; Idx > 0; --Idx)
+			{
+				Swap(TargetKeys[Idx], TargetKeys[InStream.RandHelper(Idx + 1)]);
+			}
+		}
+
+		FPCGMetadataAttribute<int64>* Keys = Data->Metadata->CreateAttribute<int64>(KeyAttribute, 0, /*bAllowsInterpolation=*/false, /*bOverrideParent=*/false);
+		for (int32 Idx = 0; Idx < InNumPoints; ++Idx)
+		{
+			Keys->SetValue(Points[Idx].MetadataEntry, TargetKeys[Idx]);
+		}
+
+		return Data;
+	}
+
+	void ConfigureSettings(UPCGCopyAttributeSettings* Settings, ECase InCase)
+	{
+		switch (InCase)
+		{
+		case ECase::AggregateSum:
+			Settings->MatchMode = EPCGCopyAttributeMatchMode::Attribute;
+			Settings->SourceMatchAttributeProperty.SetAttributeName(CountAttribute);
+			Settings->TargetMatchAttributeProperty.SetAttributeName(CountAttribute);
+			Settings->Aggregation = EPCGCopyAttributeAggregation::Sum;
+			break;
+		case ECase::MatchNearest:
+			Settings->MatchMode = EPCGCopyAttributeMatchMode::Nearest;
+			break;
+		case ECase::MatchRange:
+			Settings->MatchMode = EPCGCopyAttributeMatchMode::Range;
+			Settings->SourceMatchAttributeProperty.SetAttributeName(ValueAttribute);
+			Settings->TargetMatchAttributeProperty.SetAttributeName(ValueAttribute);
+			Settings->RangeMode = EPCGCopyAttributeRangeMode::Tolerance;
+			Settings->MatchTolerance = RangeTolerance;
+			break;
+		case ECase::MatchSample:
+			Settings->MatchMode = EPCGCopyAttributeMatchMode::Sample;
+			break;
+		default:
+			Settings->MatchMode = IsKeyMatchCase(InCase) ? EPCGCopyAttributeMatchMode::Attribute : EPCGCopyAttributeMatchMode::Index;
+			Settings->SourceMatchAttributeProperty.SetAttributeName(KeyAttribute);
+			Settings->TargetMatchAttributeProperty.SetAttributeName(KeyAttribute);
+			break;
+		}
+
+		Settings->bDeduplicateValues = InCase == ECase::DeduplicateValues;
+		Settings->bMoveInPlace = IsMoveCase(InCase);
+		Settings->bDeleteMovedAttribute = InCase == ECase::MoveRename;
+		Settings->JoinMode = InCase == ECase::InnerJoin ? EPCGCopyAttributeJoinMode::Inner : EPCGCopyAttributeJoinMode::Left;
+
+		// Every repeat measures the whole match
+		Settings->bCacheMatch = false;
+
+		switch (InCase)
+		{
+		case ECase::PropertyToAttribute:
+		case ECase::MatchSample:
+			Settings->SourceAttributeProperty.SetPointProperty(EPCGPointProperties::Density);
+			Settings->TargetAttributeProperty.SetAttributeName(CopiedAttribute);
+			break;
+		case ECase::DeduplicateValues:
+			Settings->SourceAttributeProperty.SetAttributeName(CountAttribute);
+			Settings->TargetAttributeProperty.SetAttributeName(CopiedAttribute);
+			break;
+		case ECase::MismatchedTypes:
+			Settings->SourceAttributeProperty.SetAttributeName(CountAttribute);
+			Settings->TargetAttributeProperty.SetPointProperty(EPCGPointProperties::Density);
+			break;
+		default:
+			Settings->SourceAttributeProperty.SetAttributeName(ValueAttribute);
+			Settings->TargetAttributeProperty.SetAttributeName(CopiedAttribute);
+			break;
+		}
+	}
+
+	/** Runs the element to completion, the same way the graph executor does, and returns its output. The used physical memory is sampled before the context is freed. */
+	const UPCGPointData* Execute(UPCGCopyAttributeSettings* Settings, UPCGPointData* Source, UPCGPointData* Target, double& OutSeconds, uint64& OutUsedPhysical)
+	{
+		FPCGDataCollection InputData;
+
+		FPCGTaggedData& SourceInput = InputData.TaggedData.Emplace_GetRef();
+		SourceInput.Data = Source;
+		SourceInput.Pin = TEXT("Source");
+
+		FPCGTaggedData& TargetInput = InputData.TaggedData.Emplace_GetRef();
+		TargetInput.Data = Target;
+		TargetInput.Pin = TEXT("Target");
+
+		FPCGTaggedData& SettingsInput = InputData.TaggedData.Emplace_GetRef();
+		SettingsInput.Data = Settings;
+
+		FPCGElementPtr Element = Settings->GetElement();
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		FPCGContext* Context = Element->Initialize(InputData, nullptr, nullptr);
+		Context->InitializeSettings();
+
+		while (!Element->Execute(Context))
+		{
+		}
+
+		OutSeconds = FPlatformTime::Seconds() - StartTime;
+		OutUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+
+		const UPCGPointData* Output = nullptr;
+		for (const FPCGTaggedData& TaggedData : Context->OutputData.TaggedData)
+		{
+			if (const UPCGPointData* PointData = Cast<const UPCGPointData>(TaggedData.Data))
+			{
+				Output = PointData;
+				break;
+			}
+		}
+
+		delete Context;
+
+		return Output;
+	}
+
+	bool ReadAsDouble(const FPCGMetadataAttributeBase* Attribute, PCGMetadataEntryKey EntryKey, double& OutValue)
+	{
+		auto Read = [Attribute, EntryKey, &OutValue](auto Dummy) -> bool
+		{
+			using AttributeType = decltype(Dummy);
+
+			if constexpr (std::is_arithmetic_v<AttributeType>)
+			{
+				OutValue = static_cast<double>(static_cast<const FPCGMetadataAttribute<AttributeType>*>(Attribute)->GetValueFromItemKey(EntryKey));
+				return true;
+			}
+			else
+			{
+				return false;
+			}
+		};
+
+		return PCGMetadataAttribute::CallbackWithRightType(Attribute->GetTypeId(), Read);
+	}
+
+	/** Naive reference of the value copied to each target point, unset for the target points without a match. */
+	TArray<TOptional<double>> GetExpectedValues(ECase InCase, const UPCGPointData* Source, const UPCGPointData* Target)
+	{
+		const TArray<FPCGPoint>& SourcePoints = Source->GetPoints();
+		const TArray<FPCGPoint>& TargetPoints = Target->GetPoints();
+		const int32 NumSources = SourcePoints.Num();
+
+		TArray<TOptional<double>> Expected;
+		Expected.SetNum(TargetPoints.Num());
+
+		switch (InCase)
+		{
+		case ECase::AttributeToAttribute:
+		case ECase::MoveRename:
+		case ECase::MoveAlias:
+			for (int32 Idx = 0; Idx < Expected.Num(); ++Idx)
+			{
+				Expected[Idx] = GetSourceValue(Idx);
+			}
+			break;
+		case ECase::PropertyToAttribute:
+			for (int32 Idx = 0; Idx < Expected.Num(); ++Idx)
+			{
+				Expected[Idx] = GetSourceDensity(Idx);
+			}
+			break;
+		case ECase::MismatchedTypes:
+			for (int32 Idx = 0; Idx < Expected.Num(); ++Idx)
+			{
+				Expected[Idx] = static_cast<float>(GetSourceCount(Idx));
+			}
+			break;
+		case ECase::AggregateSum:
+		{
+			// Values are multiples of 0.5, so their sums are exact in any order
+			TMap<int32, double> SumByKey;
+			for (int32 Idx = 0; Idx < NumSources; ++Idx)
+			{
+				SumByKey.FindOrAdd(GetSourceCount(Idx)) += GetSourceValue(Idx);
+			}
+
+			const FPCGMetadataAttribute<int32>* TargetKeys = static_cast<const FPCGMetadataAttribute<int32>*>(Target->Metadata->GetConstAttribute(CountAttribute));
+			for (int32 Idx = 0; Idx < Expected.Num(); ++Idx)
+			{
+				if (const double* Sum = SumByKey.Find(TargetKeys->GetValueFromItemKey(TargetPoints[Idx].MetadataEntry)))
+				{
+					Expected[Idx] = *Sum;
+				}
+			}
+			break;
+		}
+		case ECase::MatchNearest:
+			// Sources are one apart along X, so the nearest one is among the few around the target. Ties go to the lowest index.
+			for (int32 Idx = 0; Idx < Expected.Num(); ++Idx)
+			{
+				const FVector& Position = TargetPoints[Idx].Transform.GetLocation();
+				const int32 Around = FMath::FloorToInt32(Position.X);
+				const int32 First = FMath::Clamp(Around - 1, 0, NumSources - 1);
+				const int32 Last = FMath::Clamp(Around + 2, 0, NumSources - 1);
+
+				int32 BestIdx = INDEX_NONE;
+				double BestDistanceSquared = TNumericLimits<double>::Max();
+				for (int32 SourceIdx = First; SourceIdx <= Last; ++SourceIdx)
+				{
+					const double DistanceSquared = FVector::DistSquared(SourcePoints[SourceIdx].Transform.GetLocation(), Position);
+					if (DistanceSquared < BestDistanceSquared)
+					{
+						BestDistanceSquared = DistanceSquared;
+						BestIdx = SourceIdx;
+					}
+				}
+
+				if (BestIdx != INDEX_NONE)
+				{
+					Expected[Idx] = GetSourceValue(BestIdx);
+				}
+			}
+			break;
+		case ECase::MatchRange:
+		{
+			// Ranges are made the same way as the element makes them, and the first source whose range contains the value wins
+			const FPCGMetadataAttribute<double>* TargetValues = static_cast<const FPCGMetadataAttribute<double>*>(Target->Metadata->GetConstAttribute(ValueAttribute));
+			for (int32 Idx = 0; Idx < Expected.Num(); ++Idx)
+			{
+				const double Value = TargetValues->GetValueFromItemKey(TargetPoints[Idx].MetadataEntry);
+				const int32 Around = FMath::FloorToInt32(Value * 2.0);
+
+				for (int32 SourceIdx = FMath::Max(Around - 2, 0); SourceIdx <= FMath::Min(Around + 3, NumSources - 1); ++SourceIdx)
+				{
+					if (GetSourceValue(SourceIdx) - RangeTolerance <= Value && Value <= GetSourceValue(SourceIdx) + RangeTolerance)
+					{
+						Expected[Idx] = GetSourceValue(SourceIdx);
+						break;
+					}
+				}
+			}
+			break;
+		}
+		case ECase::MatchSample:
+			// Even targets have exactly the bounds of a single source point, so the sample is that point. Odd targets overlap no source point.
+			for (int32 Idx = 0; Idx < Expected.Num(); Idx += 2)
+			{
+				if (Idx / 2 < NumSources)
+				{
+					Expected[Idx] = GetSourceDensity(Idx / 2);
+				}
+			}
+			break;
+		default:
+		{
+			// A map from each key to the first source point that has it
+			TMap<int64, int32> SourceIndexByKey;
+			const FPCGMetadataAttribute<int64>* SourceKeys = static_cast<const FPCGMetadataAttribute<int64>*>(Source->Metadata->GetConstAttribute(KeyAttribute));
+			for (int32 Idx = 0; Idx < NumSources; ++Idx)
+			{
+				SourceIndexByKey.FindOrAdd(SourceKeys->GetValueFromItemKey(SourcePoints[Idx].MetadataEntry), Idx);
+			}
+
+			const FPCGMetadataAttribute<int64>* TargetKeys = static_cast<const FPCGMetadataAttribute<int64>*>(Target->Metadata->GetConstAttribute(KeyAttribute));
+			for (int32 Idx = 0; Idx < Expected.Num(); ++Idx)
+			{
+				if (const int32* SourceIdx = SourceIndexByKey.Find(TargetKeys->GetValueFromItemKey(TargetPoints[Idx].MetadataEntry)))
+				{
+					Expected[Idx] = InCase == ECase::DeduplicateValues ? GetSourceCount(*SourceIdx) : GetSourceValue(*SourceIdx);
+				}
+			}
+			break;
+		}
+		}
+
+		return Expected;
+	}
+
+	/** Checks every output point against the reference. Inner joins must keep exactly the matched target points, in order. */
+	bool CheckOutput(ECase InCase, const UPCGPointData* Source, const UPCGPointData* Target, const UPCGPointData* Output)
+	{
+		if (!Output)
+		{
+			return false;
+		}
+
+		const TArray<TOptional<double>> Expected = GetExpectedValues(InCase, Source, Target);
+
+		TArray<int32> OutputToTarget;
+		for (int32 Idx = 0; Idx < Expected.Num(); ++Idx)
+		{
+			if (InCase != ECase::InnerJoin || Expected[Idx].IsSet())
+			{
+				OutputToTarget.Add(Idx);
+			}
+		}
+
+		const TArray<FPCGPoint>& OutputPoints = Output->GetPoints();
+		if (OutputPoints.Num() != OutputToTarget.Num())
+		{
+			return false;
+		}
+
+		const FPCGMetadataAttributeBase* Copied = Output->Metadata->GetConstAttribute(CopiedAttribute);
+		if (!Copied && InCase != ECase::MismatchedTypes)
+		{
+			return false;
+		}
+
+		for (int32 Idx = 0; Idx < OutputPoints.Num(); ++Idx)
+		{
+			const int32 TargetIdx = OutputToTarget[Idx];
+			if (OutputPoints[Idx].Seed != TargetIdx)
+			{
+				return false;
+			}
+
+			// Unmatched points keep the default value of the new attribute
+			double Actual = 0.0;
+			if (InCase == ECase::MismatchedTypes)
+			{
+				Actual = OutputPoints[Idx].Density;
+			}
+			else if (!ReadAsDouble(Copied, OutputPoints[Idx].MetadataEntry, Actual))
+			{
+				return false;
+			}
+
+			if (Actual != Expected[TargetIdx].Get(0.0))
+			{
+				return false;
+			}
+		}
+
+		// A rename removes the moved attribute, while an alias keeps it, still reading the same values
+		const FPCGMetadataAttributeBase* Moved = Output->Metadata->GetConstAttribute(ValueAttribute);
+		if (InCase == ECase::MoveRename && Moved)
+		{
+			return false;
+		}
+
+		if (InCase == ECase::MoveAlias)
+		{
+			if (!Moved)
+			{
+				return false;
+			}
+
+			for (int32 Idx = 0; Idx < OutputPoints.Num(); ++Idx)
+			{
+				double Actual = 0.0;
+				if (!ReadAsDouble(Moved, OutputPoints[Idx].MetadataEntry, Actual) || Actual != GetSourceValue(Idx))
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	FResult Run(ECase InCase, int32 InNumPoints, int32 InRepeat)
+	{
+		FRandomStream Stream(InNumPoints);
+		UPCGPointData* Source = MakeSource(InNumPoints);
+		UPCGPointData* Target = IsMoveCase(InCase) ? Source : MakeTarget(InCase, InNumPoints, Stream);
+
+		UPCGCopyAttributeSettings* Settings = NewObject<UPCGCopyAttributeSettings>();
+		ConfigureSettings(Settings, InCase);
+
+		FResult Result;
+		Result.Case = GetCaseName(InCase);
+		Result.NumPoints = InNumPoints;
+		Result.BestSeconds = TNumericLimits<double>::Max();
+
+		// Pools start empty for each case, so its memory and scratch allocations do not depend on the cases run before it
+		Scratch::Trim();
+		Scratch::ResetPeak();
+		const FScratchStats StatsBefore = Scratch::GetStats();
+		const uint64 UsedPhysicalBefore = FPlatformMemory::GetStats().UsedPhysical;
+		uint64 PeakUsedPhysical = UsedPhysicalBefore;
+
+		for (int32 Iteration = 0; Iteration < InRepeat; ++Iteration)
+		{
+			double Seconds = 0.0;
+			uint64 UsedPhysical = 0;
+			const UPCGPointData* Output = Execute(Settings, Source, Target, Seconds, UsedPhysical);
+			Result.BestSeconds = FMath::Min(Result.BestSeconds, Seconds);
+			PeakUsedPhysical = FMath::Max(PeakUsedPhysical, UsedPhysical);
+
+			// Every repeat does the same work, so checking the first output is enough
+			if (Iteration == 0)
+			{
+				Result.bCorrect = CheckOutput(InCase, Source, Target, Output);
+			}
+		}
+
+		const FScratchStats StatsAfter = Scratch::GetStats();
+		Result.PeakScratchBytes = StatsAfter.PeakBytesInUse - StatsBefore.BytesInUse;
+		Result.ScratchAllocations = StatsAfter.NumAllocations - StatsBefore.NumAllocations;
+		Result.UsedPhysicalDelta = static_cast<int64>(PeakUsedPhysical - UsedPhysicalBefore);
+		Result.PointsPerSecond = InNumPoints / FMath::Max(Result.BestSeconds, UE_SMALL_NUMBER);
+
+		return Result;
+	}
+
+	FString ToJson(TArrayView<const FResult> InResults)
+	{
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetStringField(TEXT("Timestamp"), FDateTime::UtcNow().ToIso8601());
+		Root->SetStringField(TEXT("BuildVersion"), FApp::GetBuildVersion());
+
+		TArray<TSharedPtr<FJsonValue>> Entries;
+		for (const FResult& Result : InResults)
+		{
+			TSharedRef<FJsonObject> Entry = MakeShared<FJsonObject>();
+			Entry->SetStringField(TEXT("Case"), Result.Case);
+			Entry->SetNumberField(TEXT("NumPoints"), Result.NumPoints);
+			Entry->SetNumberField(TEXT("BestSeconds"), Result.BestSeconds);
+			Entry->SetNumberField(TEXT("PointsPerSecond"), Result.PointsPerSecond);
+			Entry->SetNumberField(TEXT("UsedPhysicalDelta"), static_cast<double>(Result.UsedPhysicalDelta));
+			Entry->SetNumberField(TEXT("PeakScratchBytes"), static_cast<double>(Result.PeakScratchBytes));
+			Entry->SetNumberField(TEXT("ScratchAllocations"), static_cast<double>(Result.ScratchAllocations));
+			Entry->SetBoolField(TEXT("Correct"), Result.bCorrect);
+			Entries.Add(MakeShared<FJsonValueObject>(Entry));
+		}
+
+		Root->SetArrayField(TEXT("Results"), Entries);
+
+		FString Text;
+		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Text);
+		FJsonSerializer::Serialize(Root, Writer);
+
+		return Text;
+	}
+
+	FString ToCsv(TArrayView<const FResult> InResults)
+	{
+		FString Text = TEXT("Case,NumPoints,BestSeconds,PointsPerSecond,UsedPhysicalDelta,PeakScratchBytes,ScratchAllocations,Correct\n");
+		for (const FResult& Result : InResults)
+		{
+			Text += FString::Printf(TEXT("%s,%d,%f,%f,%lld,%lld,%lld,%s\n"),
+				*Result.Case,
+				Result.NumPoints,
+				Result.BestSeconds,
+				Result.PointsPerSecond,
+				Result.UsedPhysicalDelta,
+				Result.PeakScratchBytes,
+				Result.ScratchAllocations,
+				Result.bCorrect ? TEXT("true") : TEXT("false"));
+		}
+
+		return Text;
+	}
+}
+
+UPCGPlusBenchmarkCommandlet::UPCGPlusBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UPCGPlusBenchmarkCommandlet::Main(const FString& Params)
+{
+	using namespace UE::PCGPlus::Benchmark;
+
+	int32 MaxPoints = 10 * 1000 * 1000;
+	int32 Repeat = 3;
+	FString CasesParam;
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("PCGPlus") / TEXT("CopyAttributeBenchmark.json");
+
+	FParse::Value(*Params, TEXT("MaxPoints="), MaxPoints);
+	FParse::Value(*Params, TEXT("Repeat="), Repeat);
+	FParse::Value(*Params, TEXT("Cases="), CasesParam);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	Repeat = FMath::Max(Repeat, 1);
+
+	TArray<FString> CaseNames;
+	CasesParam.ParseIntoArray(CaseNames, TEXT(","));
+
+	TArray<FResult> Results;
+	bool bAllCorrect = true;
+
+	for (uint8 CaseIndex = 0; CaseIndex < static_cast<uint8>(ECase::Count); ++CaseIndex)
+	{
+		const ECase Case = static_cast<ECase>(CaseIndex);
+		if (!CaseNames.IsEmpty() && !CaseNames.Contains(GetCaseName(Case)))
+		{
+			continue;
+		}
+
+		for (int64 NumPoints = 1000; NumPoints <= MaxPoints; NumPoints *= 10)
+		{
+			const FResult& Result = Results.Add_GetRef(Run(Case, static_cast<int32>(NumPoints), Repeat));
+			bAllCorrect &= Result.bCorrect;
+
+			UE_LOG(LogPCGPlusBenchmark, Display, TEXT("%s, %d points: %.3f ms, %.2f M points/s, %.1f MB scratch peak, %lld scratch allocations%s"),
+				*Result.Case,
+				Result.NumPoints,
+				Result.BestSeconds * 1000.0,
+				Result.PointsPerSecond / 1.0e6,
+				Result.PeakScratchBytes / (1024.0 * 1024.0),
+				Result.ScratchAllocations,
+				Result.bCorrect ? TEXT("") : TEXT(", WRONG OUTPUT"));
+
+			// The data of each run is dropped before the next one, so it does not weigh on its memory
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		}
+	}
+
+	const FString Text = OutputPath.EndsWith(TEXT(".csv")) ? ToCsv(Results) : ToJson(Results);
+	if (!FFileHelper::SaveStringToFile(Text, *OutputPath))
+	{
+		UE_LOG(LogPCGPlusBenchmark, Error, TEXT("Failed to write the results to '%s'"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogPCGPlusBenchmark, Display, TEXT("Results written to '%s'"), *OutputPath);
+
+	return bAllCorrect ? 0 : 1;
+}
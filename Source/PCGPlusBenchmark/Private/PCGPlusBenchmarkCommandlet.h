@@ -0,0 +1,27 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "PCGPlusBenchmarkCommandlet.generated.h"
+
+/**
+ * Benchmarks Copy Attribute on synthetic point data, from 1K points up to -MaxPoints (10M by default), and checks each output against a reference join.
+ * Results are written to -Output, as CSV if the file ends in .csv and as JSON otherwise, so runs on different commits can be compared.
+ *
+ * UnrealEditor-Cmd <Project> -run=PCGPlusBenchmark -nullrhi -unattended [-MaxPoints=10000000] [-Repeat=3] [-Cases=MatchShuffled,MatchSparse] [-Output=<File>]
+ *
+ * Returns 1 if any output is wrong.
+ */
+UCLASS()
+class UPCGPlusBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPCGPlusBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};